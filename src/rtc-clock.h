@@ -0,0 +1,315 @@
+/*
+ * rtc-clock.h
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Generic interface of a real time clock, independent of the hardware.
+ *
+ * The interface is statically dispatched (CRTP): a backend derives from
+ * rtc_clock<backend> and implements the functions below with the same
+ * signatures; code written against rtc_clock<T> calls the backend directly,
+ * without virtual functions. A backend must also define the alarm_a and
+ * alarm_b constants, and describe its calibration: CAL_STEP_PPM, the step of
+ * the calibration factor in ppm (a positive factor speeds the clock up), and
+ * CAL_MIN and CAL_MAX, the range of the factor. A function missing in the
+ * backend would recurse into the interface, therefore the constructor checks
+ * at compile time that all of them are implemented.
+ */
+
+#ifndef INCLUDE_RTC_CLOCK_H_
+#define INCLUDE_RTC_CLOCK_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined (__cplusplus)
+
+#include <type_traits>
+
+class rtc_clock_base
+{
+public:
+  typedef enum
+  {
+    ok = 0,                     // same values as the HAL errors
+    error = 1,
+    busy = 2,
+    timeout = 3,
+    invalid_param = 10,         // RTC specific
+  } rtc_result_t;
+
+  static constexpr int alarm_ignored = -1;
+};
+
+template<typename T>
+  class rtc_clock : public rtc_clock_base
+  {
+  public:
+    rtc_result_t
+    set_time (time_t* u_time);
+
+    rtc_result_t
+    get_time (time_t* u_time);
+
+    rtc_result_t
+    get_time (time_t* u_time, uint32_t* usec);
+
+    rtc_result_t
+    shift_time (int32_t usec);
+
+    rtc_result_t
+    set_cal_factor (int cal_factor);
+
+    int
+    get_cal_factor (void);
+
+    rtc_result_t
+    set_alarm (int which, struct tm* when);
+
+    rtc_result_t
+    get_alarm (int which, struct tm* when);
+
+    rtc_result_t
+    reset_alarm (int which);
+
+    rtc_result_t
+    set_wakeup (uint16_t seconds);
+
+    uint32_t
+    get_bk_register (uint8_t reg_nr);
+
+    void
+    set_bk_register (uint8_t reg_nr, uint32_t value);
+
+  protected:
+    rtc_clock ();
+
+    ~rtc_clock () = default;
+
+  private:
+    T&
+    impl (void);
+
+    template<typename F, typename C>
+      static constexpr bool
+      implemented (F C::*);
+  };
+
+/**
+ * @brief  Check if a member function is declared by the backend, rather
+ *      than inherited from the interface.
+ * @param  F: type of the function, to choose among overloads.
+ * @return true if the function is a member of the backend.
+ */
+template<typename T>
+  template<typename F, typename C>
+    constexpr bool
+    rtc_clock<T>::implemented (F C::*)
+    {
+      return std::is_same<C, T>::value;
+    }
+
+/**
+ * @brief  Constructor; check that the backend implements all the functions.
+ */
+template<typename T>
+  inline
+  rtc_clock<T>::rtc_clock ()
+  {
+    static_assert (implemented<rtc_result_t (time_t*)> (&T::set_time),
+                   "backend must implement set_time (time_t*)");
+    static_assert (implemented<rtc_result_t (time_t*)> (&T::get_time),
+                   "backend must implement get_time (time_t*)");
+    static_assert (
+        implemented<rtc_result_t (time_t*, uint32_t*)> (&T::get_time),
+        "backend must implement get_time (time_t*, uint32_t*)");
+    static_assert (implemented<rtc_result_t (int32_t)> (&T::shift_time),
+                   "backend must implement shift_time (int32_t)");
+    static_assert (implemented<rtc_result_t (int)> (&T::set_cal_factor),
+                   "backend must implement set_cal_factor (int)");
+    static_assert (implemented<int (void)> (&T::get_cal_factor),
+                   "backend must implement get_cal_factor (void)");
+    static_assert (
+        implemented<rtc_result_t (int, struct tm*)> (&T::set_alarm),
+        "backend must implement set_alarm (int, struct tm*)");
+    static_assert (
+        implemented<rtc_result_t (int, struct tm*)> (&T::get_alarm),
+        "backend must implement get_alarm (int, struct tm*)");
+    static_assert (implemented<rtc_result_t (int)> (&T::reset_alarm),
+                   "backend must implement reset_alarm (int)");
+    static_assert (implemented<rtc_result_t (uint16_t)> (&T::set_wakeup),
+                   "backend must implement set_wakeup (uint16_t)");
+    static_assert (implemented<uint32_t (uint8_t)> (&T::get_bk_register),
+                   "backend must implement get_bk_register (uint8_t)");
+    static_assert (
+        implemented<void (uint8_t, uint32_t)> (&T::set_bk_register),
+        "backend must implement set_bk_register (uint8_t, uint32_t)");
+    static_assert (T::CAL_STEP_PPM > 0,
+                   "backend must define CAL_STEP_PPM, the calibration step");
+    static_assert (T::CAL_MIN <= 0 && T::CAL_MAX >= 0,
+                   "backend must define CAL_MIN and CAL_MAX, the range of "
+                   "the calibration factor");
+  }
+
+/**
+ * @brief  Return the backend.
+ */
+template<typename T>
+  inline T&
+  rtc_clock<T>::impl (void)
+  {
+    return static_cast<T&> (*this);
+  }
+
+/**
+ * @brief  Set the clock from a Unix time value (UTC).
+ */
+template<typename T>
+  inline rtc_clock_base::rtc_result_t
+  rtc_clock<T>::set_time (time_t* u_time)
+  {
+    return impl ().set_time (u_time);
+  }
+
+/**
+ * @brief  Return the current time as Unix time (UTC).
+ */
+template<typename T>
+  inline rtc_clock_base::rtc_result_t
+  rtc_clock<T>::get_time (time_t* u_time)
+  {
+    return impl ().get_time (u_time);
+  }
+
+/**
+ * @brief  Return the current time as Unix time (UTC) and microseconds.
+ */
+template<typename T>
+  inline rtc_clock_base::rtc_result_t
+  rtc_clock<T>::get_time (time_t* u_time, uint32_t* usec)
+  {
+    return impl ().get_time (u_time, usec);
+  }
+
+/**
+ * @brief  Shift the clock by less than one second, forward if positive.
+ */
+template<typename T>
+  inline rtc_clock_base::rtc_result_t
+  rtc_clock<T>::shift_time (int32_t usec)
+  {
+    return impl ().shift_time (usec);
+  }
+
+/**
+ * @brief  Set the calibration factor, from T::CAL_MIN to T::CAL_MAX, in
+ *      steps of T::CAL_STEP_PPM; a positive factor speeds the clock up.
+ */
+template<typename T>
+  inline rtc_clock_base::rtc_result_t
+  rtc_clock<T>::set_cal_factor (int cal_factor)
+  {
+    return impl ().set_cal_factor (cal_factor);
+  }
+
+/**
+ * @brief  Return the calibration factor.
+ */
+template<typename T>
+  inline int
+  rtc_clock<T>::get_cal_factor (void)
+  {
+    return impl ().get_cal_factor ();
+  }
+
+/**
+ * @brief  Set an alarm (UTC); fields set to alarm_ignored are masked. The
+ *      alarm is on a day of the month (tm_mday) or, if that is ignored, on a
+ *      day of the week (tm_wday, 0 is Sunday).
+ */
+template<typename T>
+  inline rtc_clock_base::rtc_result_t
+  rtc_clock<T>::set_alarm (int which, struct tm* when)
+  {
+    return impl ().set_alarm (which, when);
+  }
+
+/**
+ * @brief  Return the current values of an alarm, as set; the masked fields,
+ *      and tm_wday of an alarm on a day of the month, are alarm_ignored.
+ */
+template<typename T>
+  inline rtc_clock_base::rtc_result_t
+  rtc_clock<T>::get_alarm (int which, struct tm* when)
+  {
+    return impl ().get_alarm (which, when);
+  }
+
+/**
+ * @brief  Switch an alarm off.
+ */
+template<typename T>
+  inline rtc_clock_base::rtc_result_t
+  rtc_clock<T>::reset_alarm (int which)
+  {
+    return impl ().reset_alarm (which);
+  }
+
+/**
+ * @brief  Set the wake-up timer.
+ */
+template<typename T>
+  inline rtc_clock_base::rtc_result_t
+  rtc_clock<T>::set_wakeup (uint16_t seconds)
+  {
+    return impl ().set_wakeup (seconds);
+  }
+
+/**
+ * @brief  Read a backup register.
+ */
+template<typename T>
+  inline uint32_t
+  rtc_clock<T>::get_bk_register (uint8_t reg_nr)
+  {
+    return impl ().get_bk_register (reg_nr);
+  }
+
+/**
+ * @brief  Write a backup register.
+ */
+template<typename T>
+  inline void
+  rtc_clock<T>::set_bk_register (uint8_t reg_nr, uint32_t value)
+  {
+    impl ().set_bk_register (reg_nr, value);
+  }
+
+#endif // (__cplusplus)
+
+#endif /* INCLUDE_RTC_CLOCK_H_ */
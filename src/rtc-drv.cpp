@@ -112,6 +112,34 @@ rtc::power (bool state)
   return result;
 }
 
+/**
+ * @brief  Convert a Unix time value to the HAL time and date structures.
+ * @param  u_time: pointer on a time_t Unix time value.
+ * @param  time: pointer to the HAL time structure.
+ * @param  date: pointer to the HAL date structure.
+ */
+static void
+hal_time (time_t* u_time, RTC_TimeTypeDef* time, RTC_DateTypeDef* date)
+{
+  struct tm tms, * timeptr;
+
+  timeptr = gmtime_r (u_time, &tms);
+
+  time->TimeFormat = RTC_HOURFORMAT_24;
+  time->DayLightSaving = RTC_DAYLIGHTSAVING_NONE;
+  time->StoreOperation = RTC_STOREOPERATION_SET;
+  time->SubSeconds = 0;
+
+  time->Seconds = timeptr->tm_sec;
+  time->Minutes = timeptr->tm_min;
+  time->Hours = timeptr->tm_hour;
+
+  date->Date = timeptr->tm_mday;
+  date->Month = timeptr->tm_mon + 1;
+  date->Year = timeptr->tm_year - 100;
+  date->WeekDay = timeptr->tm_wday + 1;
+}
+
 /**
  * @brief  Set the RTC from a Unix time value; this is always UTC.
  * @param  u_time: pointer on a time_t Unix time value.
@@ -123,23 +151,8 @@ rtc::set_time (time_t* u_time)
   RTC_TimeTypeDef RTC_TimeStructure;
   RTC_DateTypeDef RTC_DateStructure;
   rtc::rtc_result_t result = busy;
-  struct tm tms, * timeptr;
 
-  timeptr = gmtime_r (u_time, &tms);
-
-  RTC_TimeStructure.TimeFormat = RTC_HOURFORMAT_24;
-  RTC_TimeStructure.DayLightSaving = RTC_DAYLIGHTSAVING_NONE;
-  RTC_TimeStructure.StoreOperation = RTC_STOREOPERATION_SET;
-  RTC_TimeStructure.SubSeconds = 0;
-
-  RTC_TimeStructure.Seconds = timeptr->tm_sec;
-  RTC_TimeStructure.Minutes = timeptr->tm_min;
-  RTC_TimeStructure.Hours = timeptr->tm_hour;
-
-  RTC_DateStructure.Date = timeptr->tm_mday;
-  RTC_DateStructure.Month = timeptr->tm_mon + 1;
-  RTC_DateStructure.Year = timeptr->tm_year - 100;
-  RTC_DateStructure.WeekDay = timeptr->tm_wday + 1;
+  hal_time (u_time, &RTC_TimeStructure, &RTC_DateStructure);
 
   if (mutex_.timed_lock (RTC_TIMEOUT) == rtos::result::ok)
     {
@@ -150,23 +163,70 @@ rtc::set_time (time_t* u_time)
           result = (rtc_result_t) HAL_RTC_SetDate (hrtc_, &RTC_DateStructure,
           FORMAT_BIN);
         }
+      if (result == error || result == timeout)
+        leave_init ();
       mutex_.unlock ();
     }
   return result;
 }
 
 /**
- * @brief  Return the current RTC value as Unix time; this is always UTC.
+ * @brief  Start setting the RTC from a Unix time value, without waiting for
+ *      the RTC to enter the init mode; this is always UTC. The operation is
+ *      completed by rtc::poll (), see also rtc::wait ().
+ * @param  u_time: pointer on a time_t Unix time value.
+ * @param  req: request handle, signalled when the operation completes.
+ * @return rtc::ok if the operation was started, or an RTC error.
+ */
+rtc::rtc_result_t
+rtc::set_time_async (time_t* u_time, request* req)
+{
+  RTC_TimeTypeDef time;
+  RTC_DateTypeDef date;
+  rtc::rtc_result_t result = busy;
+
+  hal_time (u_time, &time, &date);
+
+  if (mutex_.timed_lock (RTC_TIMEOUT) == rtos::result::ok)
+    {
+      result = start (req);
+      if (result == ok)
+        {
+          tr_ = (((uint32_t) RTC_ByteToBcd2 (time.Hours) << 16U)
+              | ((uint32_t) RTC_ByteToBcd2 (time.Minutes) << 8U)
+              | ((uint32_t) RTC_ByteToBcd2 (time.Seconds))
+              | ((uint32_t) time.TimeFormat << 16U)) & RTC_TR_RESERVED_MASK;
+          dr_ = (((uint32_t) RTC_ByteToBcd2 (date.Year) << 16U)
+              | ((uint32_t) RTC_ByteToBcd2 (date.Month) << 8U)
+              | ((uint32_t) RTC_ByteToBcd2 (date.Date))
+              | ((uint32_t) date.WeekDay << 13U)) & RTC_DR_RESERVED_MASK;
+
+          // request the init mode, rtc::poll () waits for INITF
+          __HAL_RTC_WRITEPROTECTION_DISABLE(hrtc_);
+          hrtc_->Instance->ISR = (uint32_t) RTC_INIT_MASK;
+          state_ = time_init;
+        }
+      mutex_.unlock ();
+    }
+  return result;
+}
+
+/**
+ * @brief  Return the current RTC value as Unix time, with the fraction of
+ *      the second; this is always UTC. The resolution of the fraction is
+ *      1/(PREDIV_S + 1) s, 1/1024 s if the RTC was initialized by power ().
  * @param  u_time: pointer on a time_t.
+ * @param  usec: pointer returning the microseconds, may be nullptr.
  * @return rtc::ok if successful, or an RTC error.
  */
 rtc::rtc_result_t
-rtc::get_time (time_t* u_time)
+rtc::get_time (time_t* u_time, uint32_t* usec)
 {
   RTC_TimeTypeDef RTC_TimeStructure;
   RTC_DateTypeDef RTC_DateStructure;
   rtc::rtc_result_t result = busy;
   struct tm timestruct, tmp;
+  int32_t subsec;
 
   memset (&timestruct, 0, sizeof(struct tm));
 
@@ -196,6 +256,21 @@ rtc::get_time (time_t* u_time)
               *u_time = mktime (&timestruct);
               *u_time -= difftime (mktime (gmtime_r (u_time, &tmp)),
                                    mktime (localtime_r (u_time, &tmp)));
+
+              // after a shift, the sub-seconds counter may be larger than
+              // the prescaler, the time is then one second less
+              subsec = (int32_t) RTC_TimeStructure.SecondFraction
+                  - (int32_t) RTC_TimeStructure.SubSeconds;
+              if (subsec < 0)
+                {
+                  subsec += RTC_TimeStructure.SecondFraction + 1;
+                  (*u_time)--;
+                }
+              if (usec != nullptr)
+                {
+                  *usec = (uint32_t) (((uint64_t) subsec * 1000000)
+                      / (RTC_TimeStructure.SecondFraction + 1));
+                }
             }
         }
       mutex_.unlock ();
@@ -203,6 +278,67 @@ rtc::get_time (time_t* u_time)
   return result;
 }
 
+/**
+ * @brief  Shift the RTC by a fraction of a second, e.g. to synchronize it
+ *      with a reference clock, without stopping it. The resolution of the
+ *      shift is 1/(PREDIV_S + 1) s, 1/1024 s if the RTC was initialized by
+ *      power ().
+ * @param  usec: the shift in microseconds, between -999999 (delay) and
+ *      +999999 (advance).
+ * @return rtc::ok if successful, rtc::busy if SS[15] is still set by an
+ *      earlier shift (only with PREDIV_S above 0x3FFF, for less than a
+ *      second), or an RTC error.
+ */
+rtc::rtc_result_t
+rtc::shift_time (int32_t usec)
+{
+  uint32_t add1s = RTC_SHIFTADD1S_RESET;
+  uint32_t prediv, subfs, ssr, dr;
+  rtc::rtc_result_t result = invalid_param;
+
+  if (usec > -1000000 && usec < 1000000)
+    {
+      // the prescaler in use: power () keeps it if the RTC was already
+      // initialized, e.g. by a boot loader (CubeMX uses 255)
+      prediv = hrtc_->Instance->PRER & RTC_PRER_PREDIV_S;
+      subfs = (uint32_t) (((uint64_t) (usec < 0 ? -usec : usec)
+          * (prediv + 1) + 500000) / 1000000);
+      if (subfs == 0)
+        return ok;      // less than the resolution
+
+      if (usec > 0)
+        {
+          // advance: add one second, then subtract the complement (0 to
+          // PREDIV_S, as subfs is at most PREDIV_S + 1)
+          add1s = RTC_SHIFTADD1S_SET;
+          subfs = prediv + 1 - subfs;
+        }
+      else if (subfs > prediv)
+        {
+          subfs = prediv;
+        }
+
+      result = busy;
+      if (mutex_.timed_lock (RTC_TIMEOUT) == rtos::result::ok)
+        {
+          // SS[15] must be clear, or the shift could overflow the
+          // sub-seconds counter; reading SSR locks the calendar shadow
+          // registers until DR is read
+          ssr = hrtc_->Instance->SSR;
+          dr = hrtc_->Instance->DR;
+          (void) dr;
+          if ((ssr & 0x8000) == 0)
+            {
+              result = (rtc_result_t) HAL_RTCEx_SetSynchroShift (hrtc_,
+                                                                 add1s,
+                                                                 subfs);
+            }
+          mutex_.unlock ();
+        }
+    }
+  return result;
+}
+
 /**
  * @brief  Set the calibration factor.
  * @param  cal_factor: calibration factor (from -511 to +512).
@@ -215,7 +351,7 @@ rtc::set_cal_factor (int cal_factor)
   uint32_t calib_plus_pulses;
   rtc::rtc_result_t result = invalid_param;
 
-  if (cal_factor >= -511 && cal_factor <= 512)
+  if (cal_factor >= CAL_MIN && cal_factor <= CAL_MAX)
     {
       if (cal_factor > 0)
         {
@@ -252,6 +388,85 @@ rtc::get_cal_factor (void)
   return cal_factor;
 }
 
+/**
+ * @brief  Convert an alarm specification to the HAL alarm structure.
+ * @param  which: which alarm, rtc::alarm_a or rtc::alarm_b.
+ * @param  when: a struct tm containing the alarm's specification.
+ * @param  alarm: pointer to the HAL alarm structure.
+ */
+static void
+hal_alarm (int which, struct tm* when, RTC_AlarmTypeDef* alarm)
+{
+  alarm->AlarmMask = 0;
+
+  if (when->tm_wday < 0 && when->tm_mday < 0)
+    {
+      // no weekday, no month-day specified, therefore mask the day
+      alarm->AlarmMask |= RTC_ALARMMASK_DATEWEEKDAY;
+      alarm->AlarmDateWeekDaySel = RTC_ALARMDATEWEEKDAYSEL_DATE;
+      alarm->AlarmDateWeekDay = 1;   // still need a valid day here
+    }
+  else
+    {
+      if (when->tm_mday > 0)
+        {
+          // day of month specified
+          alarm->AlarmDateWeekDay = (uint8_t) when->tm_mday;
+          alarm->AlarmDateWeekDaySel = RTC_ALARMDATEWEEKDAYSEL_DATE;
+        }
+      else
+        {
+          // day of week specified, the RTC counts from Monday (1) to
+          // Sunday (7)
+          alarm->AlarmDateWeekDay =
+              when->tm_wday ? (uint8_t) when->tm_wday : RTC_WEEKDAY_SUNDAY;
+          alarm->AlarmDateWeekDaySel = RTC_ALARMDATEWEEKDAYSEL_WEEKDAY;
+        }
+    }
+
+  if (when->tm_hour < 0)
+    {
+      // no hours specified, so we mask the hours
+      alarm->AlarmMask |= RTC_ALARMMASK_HOURS;
+      alarm->AlarmTime.Hours = 0;
+    }
+  else
+    {
+      alarm->AlarmTime.Hours = (uint8_t) when->tm_hour;
+    }
+
+  if (when->tm_min < 0)
+    {
+      // no minutes specified, so we mask the minutes
+      alarm->AlarmMask |= RTC_ALARMMASK_MINUTES;
+      alarm->AlarmTime.Minutes = 0;
+    }
+  else
+    {
+      alarm->AlarmTime.Minutes = when->tm_min;
+    }
+
+  if (when->tm_sec < 0)
+    {
+      // no seconds specified, so we mask the seconds
+      alarm->AlarmMask |= RTC_ALARMMASK_SECONDS;
+      alarm->AlarmTime.Seconds = 0;
+    }
+  else
+    {
+      alarm->AlarmTime.Seconds = when->tm_sec;
+    }
+
+  // initialize the rest
+  alarm->Alarm = which;
+  alarm->AlarmSubSecondMask = RTC_ALARMSUBSECONDMASK_ALL;
+  alarm->AlarmTime.DayLightSaving = RTC_DAYLIGHTSAVING_NONE;
+  alarm->AlarmTime.TimeFormat = RTC_HOURFORMAT12_AM;
+  alarm->AlarmTime.SubSeconds = 0;
+  alarm->AlarmTime.SecondFraction = 0;
+  alarm->AlarmTime.StoreOperation = RTC_STOREOPERATION_RESET;
+}
+
 /**
  * @brief  Set an alarm. Note that alarm values must be specified in UTC!
  *      Obviously, if the alarm definition includes only seconds and minutes,
@@ -270,74 +485,59 @@ rtc::set_alarm (int which, struct tm* when)
   result = (rtc_result_t) HAL_RTC_DeactivateAlarm (hrtc_, which);
   if (result == ok)
     {
-      alarm.AlarmMask = 0;
+      hal_alarm (which, when, &alarm);
+      result = (rtc_result_t) HAL_RTC_SetAlarm_IT (hrtc_, &alarm, FORMAT_BIN);
+    }
+  return result;
+}
 
-      if (when->tm_wday < 0 && when->tm_mday < 0)
-        {
-          // no weekday, no month-day specified, therefore mask the day
-          alarm.AlarmMask |= RTC_ALARMMASK_DATEWEEKDAY;
-          alarm.AlarmDateWeekDaySel = RTC_ALARMDATEWEEKDAYSEL_DATE;
-          alarm.AlarmDateWeekDay = 1;   // still need a valid day here
-        }
-      else
-        {
-          if (when->tm_mday > 0)
-            {
-              // day of month specified
-              alarm.AlarmDateWeekDay = (uint8_t) when->tm_mday;
-              alarm.AlarmDateWeekDaySel = RTC_ALARMDATEWEEKDAYSEL_DATE;
-            }
-          else
-            {
-              // day of week specified
-              alarm.AlarmDateWeekDay = (uint8_t) when->tm_wday;
-              alarm.AlarmDateWeekDaySel = RTC_ALARMDATEWEEKDAYSEL_WEEKDAY;
-            }
-        }
+/**
+ * @brief  Start setting an alarm, without waiting for the alarm registers
+ *      to become writable. The operation is completed by rtc::poll (), see
+ *      also rtc::wait (). Note that alarm values must be specified in UTC!
+ * @param  which: which alarm, rtc::alarm_a or rtc::alarm_b.
+ * @param  when: a struct tm containing the alarm's specification.
+ * @param  req: request handle, signalled when the operation completes.
+ * @return rtc::ok if the operation was started, or an RTC error.
+ */
+rtc::rtc_result_t
+rtc::set_alarm_async (int which, struct tm* when, request* req)
+{
+  RTC_AlarmTypeDef alarm;
+  rtc::rtc_result_t result;
 
-      if (when->tm_hour < 0)
-        {
-          // no hours specified, so we mask the hours
-          alarm.AlarmMask |= RTC_ALARMMASK_HOURS;
-          alarm.AlarmTime.Hours = 0;
-        }
-      else
-        {
-          alarm.AlarmTime.Hours = (uint8_t) when->tm_hour;
-        }
+  if (which != alarm_a && which != alarm_b)
+    return invalid_param;
 
-      if (when->tm_min < 0)
-        {
-          // no minutes specified, so we mask the minutes
-          alarm.AlarmMask |= RTC_ALARMMASK_MINUTES;
-          alarm.AlarmTime.Minutes = 0;
-        }
-      else
-        {
-          alarm.AlarmTime.Minutes = when->tm_min;
-        }
+  hal_alarm (which, when, &alarm);
 
-      if (when->tm_sec < 0)
+  result = start (req);
+  if (result == ok)
+    {
+      alrmr_ = ((uint32_t) RTC_ByteToBcd2 (alarm.AlarmTime.Hours) << 16U)
+          | ((uint32_t) RTC_ByteToBcd2 (alarm.AlarmTime.Minutes) << 8U)
+          | ((uint32_t) RTC_ByteToBcd2 (alarm.AlarmTime.Seconds))
+          | ((uint32_t) alarm.AlarmTime.TimeFormat << 16U)
+          | ((uint32_t) RTC_ByteToBcd2 (alarm.AlarmDateWeekDay) << 24U)
+          | ((uint32_t) alarm.AlarmDateWeekDaySel)
+          | ((uint32_t) alarm.AlarmMask);
+      alrmssr_ = (uint32_t) alarm.AlarmTime.SubSeconds
+          | (uint32_t) alarm.AlarmSubSecondMask;
+      which_ = which;
+
+      // disable the alarm, rtc::poll () waits for the write flag
+      __HAL_RTC_WRITEPROTECTION_DISABLE(hrtc_);
+      if (which == alarm_a)
         {
-          // no seconds specified, so we mask the seconds
-          alarm.AlarmMask |= RTC_ALARMMASK_SECONDS;
-          alarm.AlarmTime.Seconds = 0;
+          __HAL_RTC_ALARMA_DISABLE(hrtc_);
+          __HAL_RTC_ALARM_DISABLE_IT(hrtc_, RTC_IT_ALRA);
         }
       else
         {
-          alarm.AlarmTime.Seconds = when->tm_sec;
+          __HAL_RTC_ALARMB_DISABLE(hrtc_);
+          __HAL_RTC_ALARM_DISABLE_IT(hrtc_, RTC_IT_ALRB);
         }
-
-      // initialize the rest
-      alarm.Alarm = which;
-      alarm.AlarmSubSecondMask = RTC_ALARMSUBSECONDMASK_ALL;
-      alarm.AlarmTime.DayLightSaving = RTC_DAYLIGHTSAVING_NONE;
-      alarm.AlarmTime.TimeFormat = RTC_HOURFORMAT12_AM;
-      alarm.AlarmTime.SubSeconds = 0;
-      alarm.AlarmTime.SecondFraction = 0;
-      alarm.AlarmTime.StoreOperation = RTC_STOREOPERATION_RESET;
-
-      result = (rtc_result_t) HAL_RTC_SetAlarm_IT (hrtc_, &alarm, FORMAT_BIN);
+      state_ = alarm_write;
     }
   return result;
 }
@@ -358,25 +558,28 @@ rtc::get_alarm (int which, struct tm* when)
 
   if (result == rtc::ok)
     {
-      when->tm_wday =
-          (alarm.AlarmMask & RTC_ALARMMASK_DATEWEEKDAY) ?
-              alarm.AlarmDateWeekDay : alarm_ignored;
-
-      when->tm_mday =
-          (alarm.AlarmMask & RTC_ALARMDATEWEEKDAYSEL_DATE) ?
-              alarm.AlarmDateWeekDay : alarm_ignored;
+      // a set mask bit means the field is ignored
+      when->tm_wday = alarm_ignored;
+      when->tm_mday = alarm_ignored;
+      if ((alarm.AlarmMask & RTC_ALARMMASK_DATEWEEKDAY) == 0)
+        {
+          if (alarm.AlarmDateWeekDaySel == RTC_ALARMDATEWEEKDAYSEL_WEEKDAY)
+            when->tm_wday = alarm.AlarmDateWeekDay % 7;  // Sunday is 0
+          else
+            when->tm_mday = alarm.AlarmDateWeekDay;
+        }
 
       when->tm_hour =
           (alarm.AlarmMask & RTC_ALARMMASK_HOURS) ?
-              alarm.AlarmTime.Hours : alarm_ignored;
+              alarm_ignored : alarm.AlarmTime.Hours;
 
       when->tm_min =
           (alarm.AlarmMask & RTC_ALARMMASK_MINUTES) ?
-              alarm.AlarmTime.Minutes : alarm_ignored;
+              alarm_ignored : alarm.AlarmTime.Minutes;
 
       when->tm_sec =
-          (alarm.AlarmMask |= RTC_ALARMMASK_SECONDS) ?
-              alarm.AlarmTime.Seconds : alarm_ignored;
+          (alarm.AlarmMask & RTC_ALARMMASK_SECONDS) ?
+              alarm_ignored : alarm.AlarmTime.Seconds;
     }
   return result;
 }
@@ -422,3 +625,204 @@ rtc::set_bk_register (uint8_t reg_nr, uint32_t value)
 {
   HAL_RTCEx_BKUPWrite (hrtc_, reg_nr, value);
 }
+
+/**
+ * @brief  Claim the peripheral for an asynchronous operation. The HAL handle
+ *      remains locked until the operation completes, therefore any other
+ *      HAL call returns rtc::busy meanwhile.
+ * @param  req: request handle of the new operation.
+ * @return rtc::ok if successful, or rtc::busy.
+ */
+rtc::rtc_result_t
+rtc::start (request* req)
+{
+  rtos::interrupts::critical_section ics;
+
+  if (state_ != idle || hrtc_->Lock == HAL_LOCKED || !req->done_)
+    return busy;
+
+  hrtc_->Lock = HAL_LOCKED;
+  hrtc_->State = HAL_RTC_STATE_BUSY;
+  req->done_ = false;
+  req->result_ = busy;
+  req_ = req;
+  deadline_ = rtos::sysclock.now () + RTC_ASYNC_TIMEOUT;
+
+  return ok;
+}
+
+/**
+ * @brief  Release the peripheral and record the result of the pending
+ *      asynchronous operation. Must be called in a critical section.
+ * @param  result: result of the operation.
+ */
+void
+rtc::finish (rtc_result_t result)
+{
+  __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc_);
+  hrtc_->State = (result == ok) ? HAL_RTC_STATE_READY : HAL_RTC_STATE_TIMEOUT;
+  hrtc_->Lock = HAL_UNLOCKED;
+
+  req_->result_ = result;
+  state_ = idle;
+}
+
+/**
+ * @brief  Leave the init mode after a failed HAL call: when INITF does not
+ *      get set in time, the HAL returns with the init mode still requested,
+ *      and the calendar would stop as soon as INITF gets set. The HAL handle
+ *      is claimed like by a HAL call, waiting for it at most as long as a
+ *      HAL call may last.
+ */
+void
+rtc::leave_init (void)
+{
+  bool claimed = false;
+
+  for (uint32_t i = 0; !claimed && i <= RTC_ASYNC_TIMEOUT; i++)
+    {
+      if (i)
+        rtos::sysclock.sleep_for (1);
+
+      rtos::interrupts::critical_section ics;
+      if (hrtc_->Lock == HAL_UNLOCKED)
+        {
+          hrtc_->Lock = HAL_LOCKED;
+          claimed = true;
+        }
+    }
+
+  if (claimed)
+    {
+      if (hrtc_->Instance->ISR & RTC_ISR_INIT)
+        {
+          __HAL_RTC_WRITEPROTECTION_DISABLE(hrtc_);
+          hrtc_->Instance->ISR &= (uint32_t) ~RTC_ISR_INIT;
+          __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc_);
+        }
+      hrtc_->Lock = HAL_UNLOCKED;
+    }
+}
+
+/**
+ * @brief  Advance the pending asynchronous operation, if any. The function
+ *      never waits on the peripheral, it may be called from a thread, from
+ *      a timer callback or from an interrupt handler.
+ * @return true if an operation is still pending, false otherwise.
+ */
+bool
+rtc::poll (void)
+{
+  RTC_TypeDef* regs = hrtc_->Instance;
+  bool completed = false;
+  completion_t cb = nullptr;
+  void* arg = nullptr;
+  rtc_result_t result = ok;
+
+    {
+      rtos::interrupts::critical_section ics;
+
+      switch (state_)
+        {
+        case time_init:
+          if (regs->ISR & RTC_ISR_INITF)
+            {
+              regs->TR = tr_;
+              regs->DR = dr_;
+              regs->CR &= (uint32_t) ~RTC_CR_BKP;
+              regs->CR |= (uint32_t) (RTC_DAYLIGHTSAVING_NONE
+                  | RTC_STOREOPERATION_SET);
+              regs->ISR &= (uint32_t) ~RTC_ISR_INIT;
+              if (regs->CR & RTC_CR_BYPSHAD)
+                {
+                  finish (ok);
+                }
+              else
+                {
+                  // wait for the shadow registers to be synchronized
+                  regs->ISR &= (uint32_t) RTC_RSF_MASK;
+                  state_ = time_sync;
+                }
+            }
+          break;
+
+        case time_sync:
+          if (regs->ISR & RTC_ISR_RSF)
+            finish (ok);
+          break;
+
+        case alarm_write:
+          if (regs->ISR
+              & ((which_ == alarm_a) ? RTC_ISR_ALRAWF : RTC_ISR_ALRBWF))
+            {
+              if (which_ == alarm_a)
+                {
+                  regs->ALRMAR = alrmr_;
+                  regs->ALRMASSR = alrmssr_;
+                  __HAL_RTC_ALARM_CLEAR_FLAG(hrtc_, RTC_FLAG_ALRAF);
+                  __HAL_RTC_ALARMA_ENABLE(hrtc_);
+                  __HAL_RTC_ALARM_ENABLE_IT(hrtc_, RTC_IT_ALRA);
+                }
+              else
+                {
+                  regs->ALRMBR = alrmr_;
+                  regs->ALRMBSSR = alrmssr_;
+                  __HAL_RTC_ALARM_CLEAR_FLAG(hrtc_, RTC_FLAG_ALRBF);
+                  __HAL_RTC_ALARMB_ENABLE(hrtc_);
+                  __HAL_RTC_ALARM_ENABLE_IT(hrtc_, RTC_IT_ALRB);
+                }
+              __HAL_RTC_ALARM_EXTI_ENABLE_IT();
+              __HAL_RTC_ALARM_EXTI_ENABLE_RISING_EDGE();
+              finish (ok);
+            }
+          break;
+
+        default:
+          return false;
+        }
+
+      if (state_ != idle && rtos::sysclock.now () >= deadline_)
+        {
+          // leave the init mode, if still requested
+          regs->ISR &= (uint32_t) ~RTC_ISR_INIT;
+          finish (timeout);
+        }
+
+      if (state_ == idle)
+        {
+          // once done, the request may go away at any time: keep what the
+          // callback needs
+          cb = req_->cb_;
+          arg = req_->arg_;
+          result = req_->result_;
+          req_->done_ = true;
+          req_ = nullptr;
+          completed = true;
+        }
+    }
+
+  // call the completion function outside the critical section
+  if (cb != nullptr)
+    cb (result, arg);
+  return !completed;
+}
+
+/**
+ * @brief  Wait for an asynchronous operation to complete. The peripheral is
+ *      polled once per system tick, the calling thread sleeps in between
+ *      (also when another thread polls, so that one can run); the operation
+ *      always completes, at the latest on its timeout.
+ * @param  req: request handle of the operation.
+ * @return rtc::ok if successful, or an RTC error.
+ */
+rtc::rtc_result_t
+rtc::wait (request* req)
+{
+  poll ();
+  while (!req->done ())
+    {
+      rtos::sysclock.sleep_for (1);
+      poll ();
+    }
+  return req->result ();
+}
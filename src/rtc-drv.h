@@ -36,25 +36,53 @@
 
 #if defined (__cplusplus)
 
-class rtc
+#include "rtc-clock.h"
+
+class rtc : public rtc_clock<rtc>
 {
 public:
   rtc (RTC_HandleTypeDef* hrtc);
 
   ~rtc () = default;
 
-  typedef enum
-  {
-    ok = HAL_OK,                // HAL errors
-    error = HAL_ERROR,
-    busy = HAL_BUSY,
-    timeout = HAL_TIMEOUT,
-    invalid_param = 10,        // RTC specific
-  } rtc_result_t;
+  // the results are HAL errors, casted
+  static_assert (ok == (int) HAL_OK && error == (int) HAL_ERROR
+                     && busy == (int) HAL_BUSY
+                     && timeout == (int) HAL_TIMEOUT,
+                 "rtc_result_t does not match HAL_StatusTypeDef");
 
   static constexpr int alarm_a = RTC_ALARM_A;
   static constexpr int alarm_b = RTC_ALARM_B;
-  static constexpr int alarm_ignored = -1;
+
+  // smooth calibration: 1 pulse in 2^20 (about 0.954 ppm), -511 to +512
+  static constexpr double CAL_STEP_PPM = 1e6 / (1 << 20);
+  static constexpr int CAL_MIN = -511;
+  static constexpr int CAL_MAX = 512;
+
+  typedef void
+  (*completion_t) (rtc_result_t result, void* arg);
+
+  class request
+  {
+  public:
+    request (completion_t cb = nullptr, void* arg = nullptr);
+
+    ~request () = default;
+
+    bool
+    done (void);
+
+    rtc_result_t
+    result (void);
+
+  private:
+    friend class rtc;
+
+    completion_t cb_;
+    void* arg_;
+    volatile bool done_ = true;
+    volatile rtc_result_t result_ = ok;
+  };
 
   void
   get_version (uint8_t& version_major, uint8_t& version_minor,
@@ -66,9 +94,18 @@ public:
   rtc_result_t
   set_time (time_t* u_time);
 
+  rtc_result_t
+  set_time_async (time_t* u_time, request* req);
+
   rtc_result_t
   get_time (time_t* u_time);
 
+  rtc_result_t
+  get_time (time_t* u_time, uint32_t* usec);
+
+  rtc_result_t
+  shift_time (int32_t usec);
+
   rtc_result_t
   set_cal_factor (int cal_factor);
 
@@ -78,6 +115,9 @@ public:
   rtc_result_t
   set_alarm (int which, struct tm* when);
 
+  rtc_result_t
+  set_alarm_async (int which, struct tm* when, request* req);
+
   rtc_result_t
   get_alarm (int which, struct tm* when);
 
@@ -93,22 +133,59 @@ public:
   void
   set_bk_register (uint8_t reg_nr, uint32_t value);
 
+  bool
+  poll (void);
+
+  rtc_result_t
+  wait (request* req);
+
 private:
+  typedef enum
+  {
+    idle,               // no asynchronous operation pending
+    time_init,          // waiting for INITF
+    time_sync,          // waiting for RSF
+    alarm_write,        // waiting for ALRAWF or ALRBWF
+  } async_state_t;
+
+  rtc_result_t
+  start (request* req);
+
+  void
+  finish (rtc_result_t result);
+
+  void
+  leave_init (void);
+
   static constexpr uint32_t RTC_ASYNC_PREDIV = 0x1F;
   static constexpr uint32_t RTC_SYNC_PREDIV = 0x3FF;
 
   static constexpr uint8_t VERSION_MAJOR = 1;
-  static constexpr uint8_t VERSION_MINOR = 2;
-  static constexpr uint8_t VERSION_PATCH = 2;
+  static constexpr uint8_t VERSION_MINOR = 3;
+  static constexpr uint8_t VERSION_PATCH = 0;
 
-  // The mutex timeout is set to 100 ms
-  static constexpr uint32_t RTC_TIMEOUT = 100 * 1000
-      / os::rtos::sysclock.frequency_hz;
+  // The mutex timeout is set to 100 ms (in system ticks)
+  static constexpr uint32_t RTC_TIMEOUT = 100
+      * os::rtos::sysclock.frequency_hz / 1000;
+
+  // Timeout of an asynchronous operation, 1 s like the HAL's (in ticks)
+  static constexpr uint32_t RTC_ASYNC_TIMEOUT = 1000
+      * os::rtos::sysclock.frequency_hz / 1000;
 
   RTC_HandleTypeDef* hrtc_;
   os::rtos::mutex mutex_
     { "rtc" };
 
+  // asynchronous operation context
+  request* req_ = nullptr;
+  volatile async_state_t state_ = idle;
+  os::rtos::clock::timestamp_t deadline_;
+  uint32_t tr_;         // time and date registers, or
+  uint32_t dr_;
+  uint32_t alrmr_;      // alarm registers
+  uint32_t alrmssr_;
+  int which_;
+
 };
 
 /**
@@ -125,6 +202,51 @@ rtc::get_version (uint8_t& version_major, uint8_t& version_minor,
   version_patch = VERSION_PATCH;
 }
 
+/**
+ * @brief  Constructor of an asynchronous request handle.
+ * @param  cb: optional function called when the operation completes; it is
+ *      called from the context of rtc::poll (), which may be an interrupt,
+ *      after the request is done (it may already be reused or destroyed).
+ * @param  arg: argument passed to the completion function.
+ */
+inline
+rtc::request::request (completion_t cb, void* arg)
+{
+  cb_ = cb;
+  arg_ = arg;
+}
+
+/**
+ * @brief  Check if an asynchronous operation has completed.
+ * @return true if completed, false if still pending.
+ */
+inline bool
+rtc::request::done (void)
+{
+  return done_;
+}
+
+/**
+ * @brief  Return the result of a completed asynchronous operation.
+ * @return rtc::ok if successful, or an RTC error.
+ */
+inline rtc::rtc_result_t
+rtc::request::result (void)
+{
+  return result_;
+}
+
+/**
+ * @brief  Return the current RTC value as Unix time; this is always UTC.
+ * @param  u_time: pointer on a time_t.
+ * @return rtc::ok if successful, or an RTC error.
+ */
+inline rtc::rtc_result_t
+rtc::get_time (time_t* u_time)
+{
+  return get_time (u_time, nullptr);
+}
+
 /**
  * @brief  Switch an alarm off.
  * @param  which: which alarm, rtc::alarm_a or rtc::alarm_b.
@@ -0,0 +1,457 @@
+/*
+ * rtc-sim.h
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Simulated RTC, a backend of the rtc_clock interface without any hardware
+ * dependency; it can be used to run generic code on a host. The simulated
+ * time does not run by itself, it is advanced by calling advance (). The
+ * oscillator may be given a frequency error (drift), which is compensated
+ * by the calibration factor, like on the STM32F7. The class is not thread
+ * safe.
+ */
+
+#ifndef INCLUDE_RTC_SIM_H_
+#define INCLUDE_RTC_SIM_H_
+
+#include <string.h>
+
+#include "rtc-clock.h"
+
+#if defined (__cplusplus)
+
+class rtc_sim : public rtc_clock<rtc_sim>
+{
+public:
+  rtc_sim (void);
+
+  ~rtc_sim () = default;
+
+  static constexpr int alarm_a = 0;
+  static constexpr int alarm_b = 1;
+
+  // calibration like the STM32F7: 1 pulse in 2^20 (ppm), -511 to +512
+  static constexpr double CAL_STEP_PPM = 1e6 / (1 << 20);
+  static constexpr int CAL_MIN = -511;
+  static constexpr int CAL_MAX = 512;
+
+  // sub-second resolution, same as the STM32F7 driver
+  static constexpr uint32_t SUBSECONDS = 1024;
+
+  rtc_result_t
+  set_time (time_t* u_time);
+
+  rtc_result_t
+  get_time (time_t* u_time);
+
+  rtc_result_t
+  get_time (time_t* u_time, uint32_t* usec);
+
+  rtc_result_t
+  shift_time (int32_t usec);
+
+  rtc_result_t
+  set_cal_factor (int cal_factor);
+
+  int
+  get_cal_factor (void);
+
+  rtc_result_t
+  set_alarm (int which, struct tm* when);
+
+  rtc_result_t
+  get_alarm (int which, struct tm* when);
+
+  rtc_result_t
+  reset_alarm (int which);
+
+  rtc_result_t
+  set_wakeup (uint16_t seconds);
+
+  uint32_t
+  get_bk_register (uint8_t reg_nr);
+
+  void
+  set_bk_register (uint8_t reg_nr, uint32_t value);
+
+  // simulation control
+
+  void
+  advance (uint32_t usec);
+
+  void
+  set_drift (double ppm);
+
+  void
+  refuse_shifts (uint32_t count);
+
+  uint32_t
+  alarm_count (int which);
+
+  uint32_t
+  wakeup_count (void);
+
+private:
+  static constexpr int BK_REGISTERS = 32;
+
+  bool
+  alarm_match (int which, struct tm* now);
+
+  void
+  tick (void);
+
+  time_t sec_ = 0;
+  double usec_ = 0;             // fraction of the current second
+  double drift_ = 0;            // oscillator error, ppm
+  int cal_factor_ = 0;
+  uint32_t refused_ = 0;        // shifts still to refuse
+  bool alarm_on_[2];
+  struct tm alarm_[2];
+  uint32_t alarm_count_[2];
+  uint16_t wakeup_ = 0;         // wake-up period, 0 if disabled
+  uint16_t wakeup_left_ = 0;
+  uint32_t wakeup_count_ = 0;
+  uint32_t bk_[BK_REGISTERS];
+};
+
+/**
+ * @brief Constructor.
+ */
+inline
+rtc_sim::rtc_sim (void)
+{
+  memset (alarm_on_, 0, sizeof(alarm_on_));
+  memset (alarm_, 0, sizeof(alarm_));
+  memset (alarm_count_, 0, sizeof(alarm_count_));
+  memset (bk_, 0, sizeof(bk_));
+}
+
+/**
+ * @brief  Set the time; like on the real RTC, the sub-seconds are reset.
+ * @param  u_time: pointer on a time_t Unix time value.
+ * @return rtc_sim::ok.
+ */
+inline rtc_sim::rtc_result_t
+rtc_sim::set_time (time_t* u_time)
+{
+  sec_ = *u_time;
+  usec_ = 0;
+  return ok;
+}
+
+/**
+ * @brief  Return the current time as Unix time.
+ * @param  u_time: pointer on a time_t.
+ * @return rtc_sim::ok.
+ */
+inline rtc_sim::rtc_result_t
+rtc_sim::get_time (time_t* u_time)
+{
+  *u_time = sec_;
+  return ok;
+}
+
+/**
+ * @brief  Return the current time as Unix time, with the fraction of the
+ *      second, at the same resolution as the real RTC (1/1024 s).
+ * @param  u_time: pointer on a time_t.
+ * @param  usec: pointer returning the microseconds, may be nullptr.
+ * @return rtc_sim::ok.
+ */
+inline rtc_sim::rtc_result_t
+rtc_sim::get_time (time_t* u_time, uint32_t* usec)
+{
+  *u_time = sec_;
+  if (usec != nullptr)
+    *usec = (uint32_t) (usec_ * SUBSECONDS / 1e6) * 1000000 / SUBSECONDS;
+  return ok;
+}
+
+/**
+ * @brief  Shift the time by a fraction of a second, at the same resolution
+ *      as the real RTC (1/1024 s).
+ * @param  usec: the shift in microseconds, between -999999 (delay) and
+ *      +999999 (advance).
+ * @return rtc_sim::ok if successful, rtc_sim::invalid_param, or
+ *      rtc_sim::busy if refused (see refuse_shifts ()).
+ */
+inline rtc_sim::rtc_result_t
+rtc_sim::shift_time (int32_t usec)
+{
+  int32_t steps;
+
+  if (usec <= -1000000 || usec >= 1000000)
+    return invalid_param;
+  if (refused_ > 0)
+    {
+      refused_--;
+      return busy;
+    }
+
+  steps = (int32_t) ((usec < 0 ? usec * (double) SUBSECONDS - 5e5 :
+      usec * (double) SUBSECONDS + 5e5) / 1e6);
+  usec_ += steps * 1e6 / SUBSECONDS;
+  if (usec_ < 0)
+    {
+      usec_ += 1e6;
+      sec_--;
+    }
+  else if (usec_ >= 1e6)
+    {
+      usec_ -= 1e6;
+      sec_++;
+      tick ();
+    }
+  return ok;
+}
+
+/**
+ * @brief  Set the calibration factor.
+ * @param  cal_factor: calibration factor (from -511 to +512).
+ * @return rtc_sim::ok if successful, or rtc_sim::invalid_param.
+ */
+inline rtc_sim::rtc_result_t
+rtc_sim::set_cal_factor (int cal_factor)
+{
+  if (cal_factor < CAL_MIN || cal_factor > CAL_MAX)
+    return invalid_param;
+
+  cal_factor_ = cal_factor;
+  return ok;
+}
+
+/**
+ * @brief  Get the current calibration factor.
+ * @return The current calibration factor (-511 to +512).
+ */
+inline int
+rtc_sim::get_cal_factor (void)
+{
+  return cal_factor_;
+}
+
+/**
+ * @brief  Set an alarm.
+ * @param  which: which alarm, rtc_sim::alarm_a or rtc_sim::alarm_b.
+ * @param  when: a struct tm containing the alarm's specification.
+ * @return rtc_sim::ok if successful, or rtc_sim::invalid_param.
+ */
+inline rtc_sim::rtc_result_t
+rtc_sim::set_alarm (int which, struct tm* when)
+{
+  if (which != alarm_a && which != alarm_b)
+    return invalid_param;
+
+  alarm_[which] = *when;
+  if (when->tm_mday > 0)
+    alarm_[which].tm_wday = alarm_ignored;  // the day of the month wins
+  alarm_on_[which] = true;
+  return ok;
+}
+
+/**
+ * @brief  Get the current values of an alarm.
+ * @param  which: which alarm, rtc_sim::alarm_a or rtc_sim::alarm_b.
+ * @param  when: pointer to a struct tm returning the current alarm values.
+ * @return rtc_sim::ok if successful, or rtc_sim::invalid_param.
+ */
+inline rtc_sim::rtc_result_t
+rtc_sim::get_alarm (int which, struct tm* when)
+{
+  if (which != alarm_a && which != alarm_b)
+    return invalid_param;
+
+  when->tm_wday = alarm_[which].tm_wday;
+  when->tm_mday = alarm_[which].tm_mday;
+  when->tm_hour = alarm_[which].tm_hour;
+  when->tm_min = alarm_[which].tm_min;
+  when->tm_sec = alarm_[which].tm_sec;
+  return ok;
+}
+
+/**
+ * @brief  Switch an alarm off.
+ * @param  which: which alarm, rtc_sim::alarm_a or rtc_sim::alarm_b.
+ * @return rtc_sim::ok if successful, or rtc_sim::invalid_param.
+ */
+inline rtc_sim::rtc_result_t
+rtc_sim::reset_alarm (int which)
+{
+  if (which != alarm_a && which != alarm_b)
+    return invalid_param;
+
+  alarm_on_[which] = false;
+  return ok;
+}
+
+/**
+ * @brief Set the wake-up timer.
+ * @param seconds: number of seconds until the wake-up event.
+ * @return rtc_sim::ok if successful, or rtc_sim::invalid_param.
+ */
+inline rtc_sim::rtc_result_t
+rtc_sim::set_wakeup (uint16_t seconds)
+{
+  if (seconds == 0)
+    return invalid_param;
+
+  wakeup_ = wakeup_left_ = seconds;
+  return ok;
+}
+
+/**
+ * @brief Read a backup register.
+ * @param reg_nr: the number of the register to read (0 to 31).
+ * @return Value read out of the specified register.
+ */
+inline uint32_t
+rtc_sim::get_bk_register (uint8_t reg_nr)
+{
+  return (reg_nr < BK_REGISTERS) ? bk_[reg_nr] : 0;
+}
+
+/**
+ * @brief Write a backup register.
+ * @param reg_nr: the number of the register to write (0 to 31).
+ * @param value: Value to be written in the specified register.
+ */
+inline void
+rtc_sim::set_bk_register (uint8_t reg_nr, uint32_t value)
+{
+  if (reg_nr < BK_REGISTERS)
+    bk_[reg_nr] = value;
+}
+
+/**
+ * @brief  Advance the simulated time. The clock runs faster or slower than
+ *      the reference according to the drift and to the calibration factor.
+ * @param  usec: reference time elapsed, in microseconds.
+ */
+inline void
+rtc_sim::advance (uint32_t usec)
+{
+  usec_ += usec * (1 + (drift_ + cal_factor_ * CAL_STEP_PPM) / 1e6);
+  while (usec_ >= 1e6)
+    {
+      usec_ -= 1e6;
+      sec_++;
+      tick ();
+    }
+}
+
+/**
+ * @brief  Set the frequency error of the simulated oscillator.
+ * @param  ppm: error in ppm, positive if the clock runs fast.
+ */
+inline void
+rtc_sim::set_drift (double ppm)
+{
+  drift_ = ppm;
+}
+
+/**
+ * @brief  Refuse the next shifts with rtc_sim::busy, like the STM32F7
+ *      while SS[15] is set.
+ * @param  count: how many shifts to refuse.
+ */
+inline void
+rtc_sim::refuse_shifts (uint32_t count)
+{
+  refused_ = count;
+}
+
+/**
+ * @brief  Return how many times an alarm was triggered.
+ * @param  which: which alarm, rtc_sim::alarm_a or rtc_sim::alarm_b.
+ * @return Number of alarm events.
+ */
+inline uint32_t
+rtc_sim::alarm_count (int which)
+{
+  return (which == alarm_a || which == alarm_b) ? alarm_count_[which] : 0;
+}
+
+/**
+ * @brief  Return how many times the wake-up timer was triggered.
+ * @return Number of wake-up events.
+ */
+inline uint32_t
+rtc_sim::wakeup_count (void)
+{
+  return wakeup_count_;
+}
+
+/**
+ * @brief  Check if an alarm matches the current time.
+ * @param  which: which alarm, rtc_sim::alarm_a or rtc_sim::alarm_b.
+ * @param  now: current time.
+ * @return true if the alarm matches.
+ */
+inline bool
+rtc_sim::alarm_match (int which, struct tm* now)
+{
+  struct tm* when = &alarm_[which];
+
+  if (when->tm_mday > 0)
+    {
+      if (when->tm_mday != now->tm_mday)
+        return false;
+    }
+  else if (when->tm_wday >= 0 && when->tm_wday != now->tm_wday)
+    return false;
+
+  return (when->tm_hour < 0 || when->tm_hour == now->tm_hour)
+      && (when->tm_min < 0 || when->tm_min == now->tm_min)
+      && (when->tm_sec < 0 || when->tm_sec == now->tm_sec);
+}
+
+/**
+ * @brief  Handle the alarms and the wake-up timer, once per second.
+ */
+inline void
+rtc_sim::tick (void)
+{
+  struct tm now;
+
+  gmtime_r (&sec_, &now);
+  for (int i = alarm_a; i <= alarm_b; i++)
+    {
+      if (alarm_on_[i] && alarm_match (i, &now))
+        alarm_count_[i]++;
+    }
+
+  if (wakeup_ && --wakeup_left_ == 0)
+    {
+      wakeup_left_ = wakeup_;
+      wakeup_count_++;
+    }
+}
+
+#endif // (__cplusplus)
+
+#endif /* INCLUDE_RTC_SIM_H_ */
@@ -0,0 +1,556 @@
+/*
+ * rtc-sync.h
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Time synchronization: disciplines an RTC (any rtc_clock backend) from
+ * reference time samples, either offset/delay pairs measured by an NTP or
+ * PTP like protocol, or PPS time stamps.
+ *
+ * The samples go through a minimum delay filter (the sample with the
+ * smallest delay of the last few is the most accurate). Offsets of one
+ * second or more are corrected by setting the time, but only when several
+ * consecutive samples confirm them (the one with the smallest delay is
+ * used), a single bogus sample is ignored; smaller offsets are corrected by
+ * shifting the clock with the sub-second resolution of the RTC, or, below
+ * the shift limit, by slightly changing its frequency. The frequency error
+ * of the oscillator is estimated from the offsets (FLL, by a weighted least
+ * squares fit that forgets the old samples) and compensated by the
+ * calibration factor, in the steps and within the range of the backend
+ * (T::CAL_STEP_PPM, T::CAL_MIN and T::CAL_MAX).
+ *
+ * An RTC may apply the calibration over a cycle (32 s on the STM32F7); the
+ * samples should then be used at intervals of at least one cycle.
+ */
+
+#ifndef INCLUDE_RTC_SYNC_H_
+#define INCLUDE_RTC_SYNC_H_
+
+#include <stdint.h>
+#include <math.h>
+
+#include "rtc-clock.h"
+
+#if defined (__cplusplus)
+
+template<typename T>
+  class rtc_sync
+  {
+  public:
+    // samples kept by the minimum delay filter
+    static constexpr int WINDOW = 8;
+
+    // offsets above this are corrected by a shift, us
+    static constexpr int32_t SHIFT_LIMIT = 10000;
+
+    // smaller offsets are corrected by the frequency, in this time, s,
+    // but in no less than 8 sample intervals
+    static constexpr double TIME_CONSTANT = 256;
+
+    // time constant of the sample weights in the frequency estimate, s
+    static constexpr double AVERAGING_TIME = 4096;
+
+    // synchronized if the offset stays below the limit for so many samples
+    static constexpr int CONVERGED_COUNT = 4;
+
+    // offsets of one second or more set the time once confirmed by so many
+    // consecutive samples
+    static constexpr int STEP_COUNT = 3;
+
+    rtc_sync (rtc_clock<T>& clk, uint32_t limit = 2000);
+
+    ~rtc_sync () = default;
+
+    typedef rtc_clock_base::rtc_result_t rtc_result_t;
+
+    rtc_result_t
+    add_sample (int64_t offset, uint32_t delay);
+
+    rtc_result_t
+    add_pps (time_t ref_time);
+
+    void
+    reset (void);
+
+    bool
+    converged (void);
+
+    uint32_t
+    convergence_time (void);
+
+    int64_t
+    offset (void);
+
+    uint32_t
+    residual (void);
+
+    double
+    frequency (void);
+
+    uint32_t
+    steps (void);
+
+  private:
+    typedef struct
+    {
+      double free_offset;       // offset without our corrections, us
+      uint32_t delay;           // round trip delay, us
+      int64_t local;            // local time of the sample, us
+    } sample_t;
+
+    rtc_result_t
+    update (sample_t* s, int64_t now);
+
+    rtc_result_t
+    step (int64_t offset, int64_t now);
+
+    void
+    moved (int64_t shift);
+
+    void
+    stepped (int64_t shift);
+
+    rtc_clock<T>& clk_;
+    uint32_t limit_;
+
+    sample_t window_[WINDOW];
+    int count_;                 // samples in the window
+    int next_;                  // next slot to write
+    sample_t candidates_[STEP_COUNT]; // offsets of one second or more
+    int candidate_count_;
+    uint32_t min_delay_;        // smallest delay since the reset
+
+    double correction_;         // sum of all corrections, us
+    int64_t correction_local_;  // local time it was last updated
+    double interval_;           // between the last two samples, s
+    int cal_factor_;            // calibration factor in effect
+
+    bool started_;
+    int64_t start_local_;       // local time of the first sample
+    bool has_last_;
+    int64_t last_local_;        // local time of the last sample used
+    double drift_;              // estimated oscillator error, ppm
+    double sw_, sx_, sy_, sxx_, sxy_; // fit sums, x from the last sample, s
+    int64_t offset_;            // last offset
+
+    int good_;                  // consecutive samples below the limit
+    bool converged_;
+    uint32_t convergence_time_;
+    double sum_squares_;        // of the offsets since convergence
+    uint32_t sum_count_;
+    uint32_t steps_;
+  };
+
+/**
+ * @brief  Constructor.
+ * @param  clk: the clock to discipline.
+ * @param  limit: the clock is considered synchronized if the offset stays
+ *      below this limit (microseconds) for several samples.
+ */
+template<typename T>
+  inline
+  rtc_sync<T>::rtc_sync (rtc_clock<T>& clk, uint32_t limit) :
+      clk_ (clk), limit_ (limit)
+  {
+    reset ();
+  }
+
+/**
+ * @brief  Forget all samples and estimates; the calibration factor of the
+ *      clock is taken as the starting point.
+ */
+template<typename T>
+  void
+  rtc_sync<T>::reset (void)
+  {
+    count_ = next_ = 0;
+    candidate_count_ = 0;
+    min_delay_ = UINT32_MAX;
+    correction_ = 0;
+    correction_local_ = 0;
+    interval_ = 0;
+    cal_factor_ = clk_.get_cal_factor ();
+    started_ = has_last_ = false;
+    start_local_ = last_local_ = 0;
+    drift_ = -cal_factor_ * T::CAL_STEP_PPM;
+    sw_ = sx_ = sy_ = sxx_ = sxy_ = 0;
+    offset_ = 0;
+    good_ = 0;
+    converged_ = false;
+    convergence_time_ = 0;
+    sum_squares_ = 0;
+    sum_count_ = 0;
+    steps_ = 0;
+  }
+
+/**
+ * @brief  Add a reference time sample, e.g. measured by an NTP client; the
+ *      offset must have been measured against this clock, just before.
+ * @param  offset: reference time - local time, in microseconds.
+ * @param  delay: round trip delay of the measurement, in microseconds.
+ * @return ok if successful, or an RTC error.
+ */
+template<typename T>
+  typename rtc_sync<T>::rtc_result_t
+  rtc_sync<T>::add_sample (int64_t offset, uint32_t delay)
+  {
+    sample_t* best = nullptr;
+    rtc_result_t result;
+    int64_t now;
+    time_t sec;
+    uint32_t usec;
+
+    result = clk_.get_time (&sec, &usec);
+    if (result != rtc_clock_base::ok)
+      return result;
+    now = (int64_t) sec * 1000000 + usec;
+
+    // time gained by the calibration since the last sample
+    if (started_)
+      {
+        correction_ += cal_factor_ * T::CAL_STEP_PPM * (now - correction_local_)
+            / 1e6;
+        interval_ = (now - correction_local_) / 1e6;
+      }
+    correction_local_ = now;
+
+    // an offset of one second or more is kept out of the filter, until
+    // confirmed by the next samples; the best of them sets the time
+    if (offset >= 1000000 || offset <= -1000000)
+      {
+        candidates_[candidate_count_].free_offset = offset + correction_;
+        candidates_[candidate_count_].delay = delay;
+        candidates_[candidate_count_].local = now;
+        if (++candidate_count_ < STEP_COUNT)
+          return rtc_clock_base::ok;
+
+        best = &candidates_[0];
+        for (int i = 1; i < STEP_COUNT; i++)
+          {
+            if (candidates_[i].delay <= best->delay)
+              best = &candidates_[i];
+          }
+        candidate_count_ = 0;
+        return step ((int64_t) llround (best->free_offset - correction_
+            - drift_ * (now - best->local) / 1e6), now);
+      }
+    candidate_count_ = 0;
+
+    if (delay < min_delay_)
+      min_delay_ = delay;
+
+    window_[next_].free_offset = offset + correction_;
+    window_[next_].delay = delay;
+    window_[next_].local = now;
+    next_ = (next_ + 1) % WINDOW;
+    if (count_ < WINDOW)
+      count_++;
+
+    // minimum delay filter; for equal delays, the newest sample
+    for (int i = 0; i < count_; i++)
+      {
+        if (best == nullptr || window_[i].delay < best->delay
+            || (window_[i].delay == best->delay
+                && window_[i].local > best->local))
+          best = &window_[i];
+      }
+
+    // a sample is used only once, and never after a newer one
+    if (has_last_ && best->local <= last_local_)
+      return rtc_clock_base::ok;
+
+    return update (best, now);
+  }
+
+/**
+ * @brief  Add a PPS (pulse per second) time stamp. Must be called as close
+ *      as possible to the pulse, e.g. from a high priority thread woken up
+ *      by the pulse interrupt (the RTC driver can not be used in interrupts).
+ * @param  ref_time: reference time of the pulse (whole seconds, UTC).
+ * @return ok if successful, or an RTC error.
+ */
+template<typename T>
+  typename rtc_sync<T>::rtc_result_t
+  rtc_sync<T>::add_pps (time_t ref_time)
+  {
+    rtc_result_t result;
+    time_t sec;
+    uint32_t usec;
+
+    result = clk_.get_time (&sec, &usec);
+    if (result != rtc_clock_base::ok)
+      return result;
+
+    return add_sample (
+        ((int64_t) ref_time - sec) * 1000000 - (int64_t) usec, 0);
+  }
+
+/**
+ * @brief  Correct the clock with a filtered sample. The offsets are kept
+ *      free of our own corrections (shifts and calibration), the frequency
+ *      error is their rate of change (slope of the line fitted through them).
+ * @param  s: the sample.
+ * @param  now: current local time, us.
+ * @return ok if successful, or an RTC error.
+ */
+template<typename T>
+  typename rtc_sync<T>::rtc_result_t
+  rtc_sync<T>::update (sample_t* s, int64_t now)
+  {
+    rtc_result_t result = rtc_clock_base::ok;
+    double dt, decay, den, residual, tau = TIME_CONSTANT;
+    int64_t offset, limit, shift = 0;
+    int cal;
+
+    // frequency: the older samples weigh less, the origin moves to this one
+    if (has_last_)
+      {
+        dt = (s->local - last_local_) / 1e6;
+        decay = exp (-dt / AVERAGING_TIME);
+        sxx_ = (sxx_ - 2 * dt * sx_ + dt * dt * sw_) * decay;
+        sxy_ = (sxy_ - dt * sy_) * decay;
+        sx_ = (sx_ - dt * sw_) * decay;
+        sy_ *= decay;
+        sw_ *= decay;
+      }
+    // the sample interval, not the time since the last sample used: the
+    // filter may keep a sample for the whole window
+    if (tau < 8 * interval_)
+      tau = 8 * interval_;
+    sw_ += 1;
+    sy_ += s->free_offset;
+    den = sw_ * sxx_ - sx_ * sx_;
+    if (den > 0)
+      drift_ = -(sw_ * sxy_ - sx_ * sy_) / den;
+
+    if (!started_)
+      {
+        start_local_ = s->local;
+        started_ = true;
+      }
+    last_local_ = s->local;
+    has_last_ = true;
+
+    // the offset now, extrapolated from the sample
+    offset = (int64_t) llround (s->free_offset - correction_
+        - drift_ * (now - s->local) / 1e6);
+    offset_ = offset;
+
+    // phase: shift if large enough, otherwise leave it to the frequency;
+    // a sample with a long delay may have an error of half the extra delay
+    limit = SHIFT_LIMIT + (s->delay - min_delay_) / 2;
+    if (offset >= limit || offset <= -limit)
+      {
+        result = clk_.shift_time ((int32_t) offset);
+        if (result != rtc_clock_base::ok)
+          return result;
+        shift = offset;
+        moved (shift);
+      }
+    residual = (double) (offset - shift);
+
+    cal = (int) lround ((-drift_ + residual / tau) / T::CAL_STEP_PPM);
+    if (cal < T::CAL_MIN)
+      cal = T::CAL_MIN;
+    else if (cal > T::CAL_MAX)
+      cal = T::CAL_MAX;
+    if (cal != cal_factor_)
+      {
+        result = clk_.set_cal_factor (cal);
+        if (result == rtc_clock_base::ok)
+          cal_factor_ = cal;
+      }
+
+    // convergence
+    good_ = (offset < (int64_t) limit_ && offset > -(int64_t) limit_) ?
+        good_ + 1 : 0;
+    if (!converged_ && good_ >= CONVERGED_COUNT)
+      {
+        converged_ = true;
+        convergence_time_ = (uint32_t) ((last_local_ - start_local_)
+            / 1000000);
+      }
+    if (converged_)
+      {
+        sum_squares_ += (double) offset * offset;
+        sum_count_++;
+      }
+    return result;
+  }
+
+/**
+ * @brief  Set the clock, for offsets of one second or more. The samples
+ *      start over, the frequency measurement continues. If only the shift
+ *      of the fraction fails, the clock stays set to the whole second.
+ * @param  offset: reference time - local time, in microseconds.
+ * @param  now: current local time, us.
+ * @return ok if successful, or an RTC error.
+ */
+template<typename T>
+  typename rtc_sync<T>::rtc_result_t
+  rtc_sync<T>::step (int64_t offset, int64_t now)
+  {
+    rtc_result_t result;
+    int64_t target = now + offset;
+    time_t sec;
+    uint32_t usec;
+
+    sec = (time_t) (target / 1000000);
+    if (target % 1000000 < 0)
+      sec--;
+    usec = (uint32_t) (target - (int64_t) sec * 1000000);
+    result = clk_.set_time (&sec);
+    if (result != rtc_clock_base::ok)
+      return result;
+
+    if (!started_)
+      {
+        start_local_ = now;
+        started_ = true;
+      }
+    count_ = next_ = 0;
+    offset_ = offset;
+    good_ = 0;
+    converged_ = false;
+    sum_squares_ = 0;
+    sum_count_ = 0;
+    steps_++;
+
+    // the clock is set to the whole second: account for it before the
+    // shift, which may fail (the next samples then correct the rest)
+    stepped (offset - (int64_t) usec);
+    if (usec != 0)
+      {
+        result = clk_.shift_time ((int32_t) usec);
+        if (result == rtc_clock_base::ok)
+          stepped (usec);
+      }
+    return result;
+  }
+
+/**
+ * @brief  Account for a step of the clock, like moved (); the offsets
+ *      jumped, the fitted ones are moved too, to keep the slope.
+ * @param  shift: the step, us.
+ */
+template<typename T>
+  void
+  rtc_sync<T>::stepped (int64_t shift)
+  {
+    moved (shift);
+    sy_ += shift * sw_;
+    sxy_ += shift * sx_;
+  }
+
+/**
+ * @brief  Account for a correction of the clock phase; the local times
+ *      kept are moved too.
+ * @param  shift: the correction, us.
+ */
+template<typename T>
+  void
+  rtc_sync<T>::moved (int64_t shift)
+  {
+    correction_ += shift;
+    correction_local_ += shift;
+    start_local_ += shift;
+    last_local_ += shift;
+    for (int i = 0; i < count_; i++)
+      window_[i].local += shift;
+  }
+
+/**
+ * @brief  Check if the clock is synchronized.
+ * @return true if the offset stayed below the limit for several samples.
+ */
+template<typename T>
+  inline bool
+  rtc_sync<T>::converged (void)
+  {
+    return converged_;
+  }
+
+/**
+ * @brief  Return the time it took to synchronize the clock.
+ * @return Seconds from the first sample to the convergence, 0 if not yet.
+ */
+template<typename T>
+  inline uint32_t
+  rtc_sync<T>::convergence_time (void)
+  {
+    return convergence_time_;
+  }
+
+/**
+ * @brief  Return the offset of the last sample used.
+ * @return Reference time - local time, in microseconds.
+ */
+template<typename T>
+  inline int64_t
+  rtc_sync<T>::offset (void)
+  {
+    return offset_;
+  }
+
+/**
+ * @brief  Return the residual offset since the convergence.
+ * @return RMS value of the offsets, in microseconds.
+ */
+template<typename T>
+  inline uint32_t
+  rtc_sync<T>::residual (void)
+  {
+    return sum_count_ ? (uint32_t) sqrt (sum_squares_ / sum_count_) : 0;
+  }
+
+/**
+ * @brief  Return the estimated frequency error of the oscillator, before
+ *      calibration.
+ * @return Frequency error in ppm, positive if the clock runs fast.
+ */
+template<typename T>
+  inline double
+  rtc_sync<T>::frequency (void)
+  {
+    return drift_;
+  }
+
+/**
+ * @brief  Return how many times the clock was set.
+ * @return Number of steps.
+ */
+template<typename T>
+  inline uint32_t
+  rtc_sync<T>::steps (void)
+  {
+    return steps_;
+  }
+
+#endif // (__cplusplus)
+
+#endif /* INCLUDE_RTC_SYNC_H_ */
@@ -0,0 +1,53 @@
+/*
+ * trace.h
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Host replacement of the µOS++ trace channel; the output is discarded.
+ */
+
+#ifndef TEST_HOST_CMSIS_PLUS_DIAG_TRACE_H_
+#define TEST_HOST_CMSIS_PLUS_DIAG_TRACE_H_
+
+#if defined (__cplusplus)
+
+namespace os
+{
+  namespace trace
+  {
+    inline int
+    printf (const char* format __attribute__ ((unused)), ...)
+    {
+      return 0;
+    }
+  } /* namespace trace */
+} /* namespace os */
+
+#endif // (__cplusplus)
+
+#endif /* TEST_HOST_CMSIS_PLUS_DIAG_TRACE_H_ */
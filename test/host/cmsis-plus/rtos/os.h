@@ -0,0 +1,115 @@
+/*
+ * os.h
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Host replacement of the µOS++ API used by the driver. The threads run
+ * one at a time under the simulated scheduler (see host-rtos.cpp), in the
+ * simulated time; the system clock ticks at 1 kHz.
+ */
+
+#ifndef TEST_HOST_CMSIS_PLUS_RTOS_OS_H_
+#define TEST_HOST_CMSIS_PLUS_RTOS_OS_H_
+
+#include <stdint.h>
+
+#if defined (__cplusplus)
+
+namespace os
+{
+  namespace rtos
+  {
+    typedef uint32_t result_t;
+
+    namespace result
+    {
+      enum : result_t
+      {
+        ok = 0,
+        etimedout = 110,
+      };
+    } /* namespace result */
+
+    class clock
+    {
+    public:
+      typedef uint64_t timestamp_t;
+      typedef uint32_t duration_t;
+    };
+
+    class clock_systick : public clock
+    {
+    public:
+      static constexpr uint32_t frequency_hz = 1000;
+
+      timestamp_t
+      now (void);
+
+      result_t
+      sleep_for (duration_t duration);
+    };
+
+    extern clock_systick sysclock;
+
+    class mutex
+    {
+    public:
+      mutex (const char* name);
+
+      ~mutex () = default;
+
+      result_t
+      lock (void);
+
+      result_t
+      timed_lock (clock::duration_t timeout);
+
+      result_t
+      unlock (void);
+
+      // owner thread, -1 if free; only for the scheduler
+      int owner_ = -1;
+    };
+
+    namespace interrupts
+    {
+      class critical_section
+      {
+      public:
+        critical_section ();
+
+        ~critical_section ();
+      };
+    } /* namespace interrupts */
+
+  } /* namespace rtos */
+} /* namespace os */
+
+#endif // (__cplusplus)
+
+#endif /* TEST_HOST_CMSIS_PLUS_RTOS_OS_H_ */
@@ -0,0 +1,419 @@
+/*
+ * cmsis_device.h
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Host replacement of the STM32F7 device and HAL headers, for running the
+ * driver on Linux against the simulated RTC peripheral (see host-rtc.cpp).
+ * Only what the driver uses is declared; the constants have the values of
+ * the STM32F7 CMSIS and HAL headers.
+ *
+ * The registers are objects: each access goes to the simulated peripheral,
+ * which updates its flags with the simulated time and checks the access
+ * rules (write protection, init mode, write flags).
+ */
+
+#ifndef TEST_HOST_CMSIS_DEVICE_H_
+#define TEST_HOST_CMSIS_DEVICE_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#if defined (__cplusplus)
+
+// ----- Registers -------------------------------------------------------------
+
+typedef enum
+{
+  SIM_TR, SIM_DR, SIM_CR, SIM_ISR, SIM_PRER, SIM_WUTR, SIM_ALRMAR, SIM_ALRMBR,
+  SIM_WPR, SIM_SSR, SIM_SHIFTR, SIM_CALR, SIM_ALRMASSR, SIM_ALRMBSSR,
+  SIM_REGS
+} sim_reg_id_t;
+
+class sim_reg
+{
+public:
+  sim_reg (sim_reg_id_t id) :
+      id_ (id)
+  {
+  }
+
+  sim_reg (const sim_reg&) = delete;
+
+  operator uint32_t ();
+
+  sim_reg&
+  operator= (uint32_t value);
+
+  sim_reg&
+  operator&= (uint32_t value)
+  {
+    return *this = (uint32_t) *this & value;
+  }
+
+  sim_reg&
+  operator|= (uint32_t value)
+  {
+    return *this = (uint32_t) *this | value;
+  }
+
+private:
+  sim_reg_id_t id_;
+};
+
+typedef struct
+{
+  sim_reg TR
+    { SIM_TR };
+  sim_reg DR
+    { SIM_DR };
+  sim_reg CR
+    { SIM_CR };
+  sim_reg ISR
+    { SIM_ISR };
+  sim_reg PRER
+    { SIM_PRER };
+  sim_reg WUTR
+    { SIM_WUTR };
+  sim_reg ALRMAR
+    { SIM_ALRMAR };
+  sim_reg ALRMBR
+    { SIM_ALRMBR };
+  sim_reg WPR
+    { SIM_WPR };
+  sim_reg SSR
+    { SIM_SSR };
+  sim_reg SHIFTR
+    { SIM_SHIFTR };
+  sim_reg CALR
+    { SIM_CALR };
+  sim_reg ALRMASSR
+    { SIM_ALRMASSR };
+  sim_reg ALRMBSSR
+    { SIM_ALRMBSSR };
+} RTC_TypeDef;
+
+extern RTC_TypeDef sim_rtc_regs;
+
+#define RTC (&sim_rtc_regs)
+
+#define RTC_TR_RESERVED_MASK            0x007F7F7FU
+#define RTC_DR_RESERVED_MASK            0x00FFFF3FU
+#define RTC_INIT_MASK                   0xFFFFFFFFU
+#define RTC_RSF_MASK                    0xFFFFFF5FU
+
+#define RTC_ISR_ALRAWF                  0x00000001U
+#define RTC_ISR_ALRBWF                  0x00000002U
+#define RTC_ISR_WUTWF                   0x00000004U
+#define RTC_ISR_SHPF                    0x00000008U
+#define RTC_ISR_INITS                   0x00000010U
+#define RTC_ISR_RSF                     0x00000020U
+#define RTC_ISR_INITF                   0x00000040U
+#define RTC_ISR_INIT                    0x00000080U
+#define RTC_ISR_ALRAF                   0x00000100U
+#define RTC_ISR_ALRBF                   0x00000200U
+#define RTC_ISR_WUTF                    0x00000400U
+#define RTC_ISR_RECALPF                 0x00010000U
+
+#define RTC_CR_WUCKSEL                  0x00000007U
+#define RTC_CR_BYPSHAD                  0x00000020U
+#define RTC_CR_FMT                      0x00000040U
+#define RTC_CR_ALRAE                    0x00000100U
+#define RTC_CR_ALRBE                    0x00000200U
+#define RTC_CR_WUTE                     0x00000400U
+#define RTC_CR_ALRAIE                   0x00001000U
+#define RTC_CR_ALRBIE                   0x00002000U
+#define RTC_CR_WUTIE                    0x00004000U
+#define RTC_CR_BKP                      0x00040000U
+#define RTC_CR_POL                      0x00100000U
+#define RTC_CR_OSEL                     0x00600000U
+
+#define RTC_PRER_PREDIV_S               0x00007FFFU
+#define RTC_PRER_PREDIV_A               0x007F0000U
+
+#define RTC_ALRMAR_MSK1                 0x00000080U
+#define RTC_ALRMAR_MSK2                 0x00008000U
+#define RTC_ALRMAR_MSK3                 0x00800000U
+#define RTC_ALRMAR_MSK4                 0x80000000U
+#define RTC_ALRMAR_WDSEL                0x40000000U
+
+// ----- HAL ------------------------------------------------------------------
+
+typedef enum
+{
+  HAL_OK = 0x00U, HAL_ERROR = 0x01U, HAL_BUSY = 0x02U, HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+  HAL_UNLOCKED = 0x00U, HAL_LOCKED = 0x01U
+} HAL_LockTypeDef;
+
+typedef enum
+{
+  HAL_RTC_STATE_RESET = 0x00U,
+  HAL_RTC_STATE_READY = 0x01U,
+  HAL_RTC_STATE_BUSY = 0x02U,
+  HAL_RTC_STATE_TIMEOUT = 0x03U,
+  HAL_RTC_STATE_ERROR = 0x04U
+} HAL_RTCStateTypeDef;
+
+typedef enum
+{
+  RTC_WKUP_IRQn = 3, RTC_Alarm_IRQn = 41
+} IRQn_Type;
+
+typedef struct
+{
+  uint32_t HourFormat;
+  uint32_t AsynchPrediv;
+  uint32_t SynchPrediv;
+  uint32_t OutPut;
+  uint32_t OutPutPolarity;
+  uint32_t OutPutType;
+} RTC_InitTypeDef;
+
+typedef struct
+{
+  RTC_TypeDef* Instance;
+  RTC_InitTypeDef Init;
+  HAL_LockTypeDef Lock;
+  volatile HAL_RTCStateTypeDef State;
+} RTC_HandleTypeDef;
+
+typedef struct
+{
+  uint8_t Hours;
+  uint8_t Minutes;
+  uint8_t Seconds;
+  uint8_t TimeFormat;
+  uint32_t SubSeconds;
+  uint32_t SecondFraction;
+  uint32_t DayLightSaving;
+  uint32_t StoreOperation;
+} RTC_TimeTypeDef;
+
+typedef struct
+{
+  uint8_t WeekDay;
+  uint8_t Month;
+  uint8_t Date;
+  uint8_t Year;
+} RTC_DateTypeDef;
+
+typedef struct
+{
+  RTC_TimeTypeDef AlarmTime;
+  uint32_t AlarmMask;
+  uint32_t AlarmSubSecondMask;
+  uint32_t AlarmDateWeekDaySel;
+  uint8_t AlarmDateWeekDay;
+  uint32_t Alarm;
+} RTC_AlarmTypeDef;
+
+typedef struct
+{
+  uint32_t PLLState;
+} RCC_PLLInitTypeDef;
+
+typedef struct
+{
+  uint32_t OscillatorType;
+  uint32_t LSEState;
+  uint32_t LSIState;
+  RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+typedef struct
+{
+  uint32_t PeriphClockSelection;
+  uint32_t RTCClockSelection;
+} RCC_PeriphCLKInitTypeDef;
+
+#define RCC_PERIPHCLK_RTC               0x00000020U
+#define RCC_RTCCLKSOURCE_LSE            0x00000100U
+#define RCC_OSCILLATORTYPE_LSE          0x00000004U
+#define RCC_OSCILLATORTYPE_LSI          0x00000008U
+#define RCC_LSE_ON                      0x00000001U
+#define RCC_LSI_OFF                     0x00000000U
+#define RCC_PLL_NONE                    0x00000000U
+
+#define FORMAT_BIN                      0x00000000U
+#define RTC_HOURFORMAT_24               0x00000000U
+#define RTC_HOURFORMAT12_AM             0x00U
+#define RTC_OUTPUT_DISABLE              0x00000000U
+#define RTC_OUTPUT_POLARITY_HIGH        0x00000000U
+#define RTC_OUTPUT_TYPE_OPENDRAIN       0x00000000U
+#define RTC_DAYLIGHTSAVING_NONE         0x00000000U
+#define RTC_STOREOPERATION_RESET        0x00000000U
+#define RTC_STOREOPERATION_SET          RTC_CR_BKP
+#define RTC_TAMPER_1                    0x00000001U
+#define RTC_TAMPER_2                    0x00000008U
+#define RTC_TAMPER_3                    0x00000020U
+
+#define RTC_FLAG_INITS                  RTC_ISR_INITS
+#define RTC_FLAG_ALRAF                  RTC_ISR_ALRAF
+#define RTC_FLAG_ALRBF                  RTC_ISR_ALRBF
+#define RTC_IT_ALRA                     RTC_CR_ALRAIE
+#define RTC_IT_ALRB                     RTC_CR_ALRBIE
+
+#define RTC_ALARM_A                     RTC_CR_ALRAE
+#define RTC_ALARM_B                     RTC_CR_ALRBE
+#define RTC_ALARMMASK_DATEWEEKDAY       RTC_ALRMAR_MSK4
+#define RTC_ALARMMASK_HOURS             RTC_ALRMAR_MSK3
+#define RTC_ALARMMASK_MINUTES           RTC_ALRMAR_MSK2
+#define RTC_ALARMMASK_SECONDS           RTC_ALRMAR_MSK1
+#define RTC_ALARMDATEWEEKDAYSEL_DATE    0x00000000U
+#define RTC_ALARMDATEWEEKDAYSEL_WEEKDAY RTC_ALRMAR_WDSEL
+#define RTC_WEEKDAY_SUNDAY              ((uint8_t) 0x07)
+#define RTC_ALARMSUBSECONDMASK_ALL      0x00000000U
+
+#define RTC_SHIFTADD1S_RESET            0x00000000U
+#define RTC_SHIFTADD1S_SET              0x80000000U
+#define RTC_SMOOTHCALIB_PERIOD_32SEC    0x00000000U
+#define RTC_SMOOTHCALIB_PLUSPULSES_SET  0x00008000U
+#define RTC_SMOOTHCALIB_PLUSPULSES_RESET 0x00000000U
+#define RTC_WAKEUPCLOCK_CK_SPRE_16BITS  0x00000004U
+
+#define HAL_IS_BIT_CLR(REG, BIT)        (((REG) & (BIT)) == 0U)
+
+#define __HAL_RCC_RTC_ENABLE()          ((void) 0)
+#define __HAL_RCC_RTC_DISABLE()         ((void) 0)
+
+#define __HAL_RTC_WRITEPROTECTION_DISABLE(__HANDLE__) \
+  do \
+    { \
+      (__HANDLE__)->Instance->WPR = 0xCAU; \
+      (__HANDLE__)->Instance->WPR = 0x53U; \
+    } \
+  while (0)
+
+#define __HAL_RTC_WRITEPROTECTION_ENABLE(__HANDLE__) \
+  do \
+    { \
+      (__HANDLE__)->Instance->WPR = 0xFFU; \
+    } \
+  while (0)
+
+#define __HAL_RTC_ALARMA_ENABLE(__HANDLE__) \
+  ((__HANDLE__)->Instance->CR |= (RTC_CR_ALRAE))
+#define __HAL_RTC_ALARMA_DISABLE(__HANDLE__) \
+  ((__HANDLE__)->Instance->CR &= ~(RTC_CR_ALRAE))
+#define __HAL_RTC_ALARMB_ENABLE(__HANDLE__) \
+  ((__HANDLE__)->Instance->CR |= (RTC_CR_ALRBE))
+#define __HAL_RTC_ALARMB_DISABLE(__HANDLE__) \
+  ((__HANDLE__)->Instance->CR &= ~(RTC_CR_ALRBE))
+#define __HAL_RTC_ALARM_ENABLE_IT(__HANDLE__, __INTERRUPT__) \
+  ((__HANDLE__)->Instance->CR |= (__INTERRUPT__))
+#define __HAL_RTC_ALARM_DISABLE_IT(__HANDLE__, __INTERRUPT__) \
+  ((__HANDLE__)->Instance->CR &= ~(__INTERRUPT__))
+#define __HAL_RTC_ALARM_CLEAR_FLAG(__HANDLE__, __FLAG__) \
+  ((__HANDLE__)->Instance->ISR) = (~((__FLAG__) | RTC_ISR_INIT) \
+      | ((__HANDLE__)->Instance->ISR & RTC_ISR_INIT))
+#define __HAL_RTC_ALARM_EXTI_ENABLE_IT()                ((void) 0)
+#define __HAL_RTC_ALARM_EXTI_ENABLE_RISING_EDGE()       ((void) 0)
+
+uint8_t
+RTC_ByteToBcd2 (uint8_t value);
+
+HAL_StatusTypeDef
+HAL_RCC_OscConfig (RCC_OscInitTypeDef* init);
+
+HAL_StatusTypeDef
+HAL_RCCEx_PeriphCLKConfig (RCC_PeriphCLKInitTypeDef* init);
+
+void
+HAL_NVIC_SetPriority (IRQn_Type irqn, uint32_t preempt, uint32_t sub);
+
+void
+HAL_NVIC_EnableIRQ (IRQn_Type irqn);
+
+void
+HAL_NVIC_DisableIRQ (IRQn_Type irqn);
+
+HAL_StatusTypeDef
+HAL_RTC_Init (RTC_HandleTypeDef* hrtc);
+
+HAL_StatusTypeDef
+HAL_RTC_DeInit (RTC_HandleTypeDef* hrtc);
+
+HAL_StatusTypeDef
+HAL_RTC_SetTime (RTC_HandleTypeDef* hrtc, RTC_TimeTypeDef* time,
+                 uint32_t format);
+
+HAL_StatusTypeDef
+HAL_RTC_GetTime (RTC_HandleTypeDef* hrtc, RTC_TimeTypeDef* time,
+                 uint32_t format);
+
+HAL_StatusTypeDef
+HAL_RTC_SetDate (RTC_HandleTypeDef* hrtc, RTC_DateTypeDef* date,
+                 uint32_t format);
+
+HAL_StatusTypeDef
+HAL_RTC_GetDate (RTC_HandleTypeDef* hrtc, RTC_DateTypeDef* date,
+                 uint32_t format);
+
+HAL_StatusTypeDef
+HAL_RTC_SetAlarm_IT (RTC_HandleTypeDef* hrtc, RTC_AlarmTypeDef* alarm,
+                     uint32_t format);
+
+HAL_StatusTypeDef
+HAL_RTC_DeactivateAlarm (RTC_HandleTypeDef* hrtc, uint32_t alarm);
+
+HAL_StatusTypeDef
+HAL_RTC_GetAlarm (RTC_HandleTypeDef* hrtc, RTC_AlarmTypeDef* alarm,
+                  uint32_t which, uint32_t format);
+
+HAL_StatusTypeDef
+HAL_RTCEx_SetSynchroShift (RTC_HandleTypeDef* hrtc, uint32_t add1s,
+                           uint32_t subfs);
+
+HAL_StatusTypeDef
+HAL_RTCEx_SetSmoothCalib (RTC_HandleTypeDef* hrtc, uint32_t period,
+                          uint32_t plus_pulses, uint32_t minus_pulses);
+
+HAL_StatusTypeDef
+HAL_RTCEx_SetWakeUpTimer_IT (RTC_HandleTypeDef* hrtc, uint32_t counter,
+                             uint32_t clock);
+
+uint32_t
+HAL_RTCEx_DeactivateWakeUpTimer (RTC_HandleTypeDef* hrtc);
+
+HAL_StatusTypeDef
+HAL_RTCEx_DeactivateTamper (RTC_HandleTypeDef* hrtc, uint32_t tamper);
+
+uint32_t
+HAL_RTCEx_BKUPRead (RTC_HandleTypeDef* hrtc, uint32_t reg);
+
+void
+HAL_RTCEx_BKUPWrite (RTC_HandleTypeDef* hrtc, uint32_t reg, uint32_t data);
+
+#endif // (__cplusplus)
+
+#endif /* TEST_HOST_CMSIS_DEVICE_H_ */
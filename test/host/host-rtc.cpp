@@ -0,0 +1,1296 @@
+/*
+ * host-rtc.cpp
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Simulated STM32F7 RTC peripheral, and the HAL functions used by the
+ * driver. The HAL functions follow the sequences of the STM32F7 HAL (lock,
+ * write protection, init mode, polling of the flags with a 1 s timeout),
+ * so that they fail in the same way under faults.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "cmsis_device.h"
+#include "host-sim.h"
+
+// simulated duration of a register access and of a HAL call, us
+static constexpr uint32_t REG_COST = 1;
+static constexpr uint32_t HAL_COST = 5;
+
+// timeout of the HAL polling loops (RTC_TIMEOUT_VALUE), us
+static constexpr uint64_t HAL_TIMEOUT_US = 1000000;
+
+// polling interval of the HAL loops, us
+static constexpr uint32_t SPIN_US = 50;
+
+static constexpr int SHOWN_VIOLATIONS = 5;
+
+// calendar after a backup domain reset: 2000-01-01 00:00:00
+static constexpr int64_t RESET_TIME = 946684800;
+
+typedef struct
+{
+  bool armed;                   // the hardware will set the flag
+  uint64_t at;                  // at this time
+} flag_t;
+
+typedef struct
+{
+  uint64_t seq;
+  int64_t value;
+} change_t;
+
+static struct
+{
+  uint32_t prediv_s;
+  uint32_t prediv_a;
+  int64_t sec;                  // calendar, as Unix time
+  int32_t ssr;                  // sub-seconds down-counter
+  uint64_t last_us;             // calendar updated up to this time
+  uint64_t frac;                // remainder of the counting
+
+  bool init;                    // INIT bit
+  bool written;                 // TR or DR written in this init mode
+  flag_t initf;
+  flag_t rsf;
+  flag_t alrawf;
+  flag_t alrbwf;
+  flag_t wutwf;
+  uint32_t flags;               // ALRAF, ALRBF, WUTF
+
+  uint32_t cr;
+  uint32_t alrmar;
+  uint32_t alrmbr;
+  uint32_t alrmassr;
+  uint32_t alrmbssr;
+  uint32_t wutr;
+  uint32_t calr;
+  int wpr;                      // 0 protected, 1 first key, 2 unprotected
+
+  bool latched;                 // shadow registers locked by a TR/SSR read
+  uint32_t l_tr;
+  uint32_t l_dr;
+  uint32_t l_ssr;
+
+  uint32_t bkp[32];
+  int bkp_writer[32];
+
+  sim_faults_t faults;
+  uint64_t seq;
+  uint64_t time_seq;
+  change_t changes[SIM_MAX_THREADS + 1][SIM_CHANGES];
+  uint32_t violations;
+  uint32_t hal_errors;
+} periph;
+
+RTC_TypeDef sim_rtc_regs;
+
+static const char* reg_names[SIM_REGS] =
+  { "TR", "DR", "CR", "ISR", "PRER", "WUTR", "ALRMAR", "ALRMBR", "WPR", "SSR",
+      "SHIFTR", "CALR", "ALRMASSR", "ALRMBSSR" };
+
+// ----- Peripheral -------------------------------------------------------------
+
+static uint32_t
+bcd (uint32_t value)
+{
+  return ((value / 10) << 4) | (value % 10);
+}
+
+static uint32_t
+bin (uint32_t value)
+{
+  return (value >> 4) * 10 + (value & 0xF);
+}
+
+/**
+ * @brief  Return the slot of the running thread in the change records.
+ */
+static int
+slot (void)
+{
+  int self = sim_self ();
+
+  return self >= 0 ? self : SIM_MAX_THREADS;
+}
+
+/**
+ * @brief  Count a violation of the access rules; the first ones are shown.
+ */
+static void
+violation (const char* what, int reg)
+{
+  if (periph.violations++ < SHOWN_VIOLATIONS)
+    printf ("sim: %s %s (thread %d, %llu us)\n", what, reg_names[reg],
+            sim_self (), (unsigned long long) sim_now ());
+}
+
+/**
+ * @brief  Record a change made by the running thread.
+ */
+static void
+change (sim_change_t what, int64_t value)
+{
+  periph.seq++;
+  periph.changes[slot ()][what].seq = periph.seq;
+  periph.changes[slot ()][what].value = value;
+  if (what == SIM_CALENDAR || what == SIM_SHIFT)
+    periph.time_seq++;
+}
+
+static void
+arm (flag_t* flag, uint32_t delay)
+{
+  flag->armed = true;
+  flag->at = (delay == SIM_STUCK) ? UINT64_MAX : sim_now () + delay;
+}
+
+static bool
+is_set (flag_t* flag)
+{
+  return flag->armed && sim_now () >= flag->at;
+}
+
+/**
+ * @brief  Count the sub-second ticks up to now; the calendar is stopped
+ *      while INITF is set.
+ */
+static void
+advance (void)
+{
+  uint64_t now = sim_now (), end = now;
+  uint64_t period = periph.prediv_s + 1;
+  uint64_t ticks;
+  int64_t borrow;
+
+  if (periph.init && periph.initf.armed && periph.initf.at < end)
+    end = (periph.initf.at > periph.last_us) ? periph.initf.at : periph.last_us;
+
+  if (end > periph.last_us)
+    {
+      periph.frac += (end - periph.last_us) * period;
+      ticks = periph.frac / 1000000;
+      periph.frac %= 1000000;
+      periph.ssr -= (int32_t) ticks;
+      if (periph.ssr < 0)
+        {
+          borrow = (-periph.ssr + period - 1) / period;
+          periph.sec += borrow;
+          periph.ssr += (int32_t) (borrow * period);
+        }
+    }
+  periph.last_us = now;
+}
+
+static uint32_t
+encode_tr (int64_t sec)
+{
+  time_t t = (time_t) sec;
+  struct tm tms;
+
+  gmtime_r (&t, &tms);
+  return (bcd (tms.tm_hour) << 16) | (bcd (tms.tm_min) << 8)
+      | bcd (tms.tm_sec);
+}
+
+static uint32_t
+encode_dr (int64_t sec)
+{
+  time_t t = (time_t) sec;
+  struct tm tms;
+
+  gmtime_r (&t, &tms);
+  return (bcd (tms.tm_year - 100) << 16)
+      | ((uint32_t) (tms.tm_wday ? tms.tm_wday : 7) << 13)
+      | (bcd (tms.tm_mon + 1) << 8) | bcd (tms.tm_mday);
+}
+
+static int64_t
+decode (uint32_t tr, uint32_t dr)
+{
+  struct tm tms;
+
+  memset (&tms, 0, sizeof(struct tm));
+  tms.tm_hour = bin ((tr >> 16) & 0x3F);
+  tms.tm_min = bin ((tr >> 8) & 0x7F);
+  tms.tm_sec = bin (tr & 0x7F);
+  tms.tm_year = bin ((dr >> 16) & 0xFF) + 100;
+  tms.tm_mon = bin ((dr >> 8) & 0x1F) - 1;
+  tms.tm_mday = bin (dr & 0x3F);
+  return timegm (&tms);
+}
+
+static uint32_t
+read_isr (void)
+{
+  uint32_t isr = periph.flags;
+
+  if (periph.init)
+    isr |= RTC_ISR_INIT;
+  if (periph.init && is_set (&periph.initf))
+    isr |= RTC_ISR_INITF;
+  if (is_set (&periph.rsf))
+    isr |= RTC_ISR_RSF;
+  if ((encode_dr (periph.sec) & 0xFF0000) != 0)
+    isr |= RTC_ISR_INITS;
+  if (is_set (&periph.alrawf))
+    isr |= RTC_ISR_ALRAWF;
+  if (is_set (&periph.alrbwf))
+    isr |= RTC_ISR_ALRBWF;
+  if (is_set (&periph.wutwf))
+    isr |= RTC_ISR_WUTWF;
+  return isr;
+}
+
+/**
+ * @brief  Read the calendar through the shadow registers: reading TR or SSR
+ *      locks them, until DR is read.
+ */
+static void
+latch (void)
+{
+  if (!periph.latched && !(periph.cr & RTC_CR_BYPSHAD))
+    {
+      periph.l_tr = encode_tr (periph.sec);
+      periph.l_dr = encode_dr (periph.sec);
+      periph.l_ssr = (uint32_t) periph.ssr;
+      periph.latched = true;
+    }
+}
+
+sim_reg::operator uint32_t ()
+{
+  uint32_t value = 0;
+
+  sim_yield (REG_COST);
+  advance ();
+
+  switch (id_)
+    {
+    case SIM_TR:
+      latch ();
+      value = periph.latched ? periph.l_tr : encode_tr (periph.sec);
+      break;
+    case SIM_SSR:
+      latch ();
+      value = periph.latched ? periph.l_ssr : (uint32_t) periph.ssr;
+      break;
+    case SIM_DR:
+      value = periph.latched ? periph.l_dr : encode_dr (periph.sec);
+      periph.latched = false;
+      break;
+    case SIM_CR:
+      value = periph.cr;
+      break;
+    case SIM_ISR:
+      value = read_isr ();
+      break;
+    case SIM_PRER:
+      value = periph.prediv_s | (periph.prediv_a << 16);
+      break;
+    case SIM_WUTR:
+      value = periph.wutr;
+      break;
+    case SIM_ALRMAR:
+      value = periph.alrmar;
+      break;
+    case SIM_ALRMBR:
+      value = periph.alrmbr;
+      break;
+    case SIM_ALRMASSR:
+      value = periph.alrmassr;
+      break;
+    case SIM_ALRMBSSR:
+      value = periph.alrmbssr;
+      break;
+    case SIM_CALR:
+      value = periph.calr;
+      break;
+    default:
+      break;
+    }
+  return value;
+}
+
+/**
+ * @brief  Write ISR: INIT is read/write, the event flags are cleared by
+ *      writing 0, RSF too; the other flags are read only.
+ */
+static void
+write_isr (uint32_t value)
+{
+  bool init = value & RTC_ISR_INIT;
+
+  periph.flags &= value | ~(RTC_ISR_ALRAF | RTC_ISR_ALRBF | RTC_ISR_WUTF);
+
+  if (periph.wpr != 2)
+    {
+      if (init != periph.init || !(value & RTC_ISR_RSF))
+        violation ("write protected", SIM_ISR);
+      return;
+    }
+
+  if (init && !periph.init)
+    {
+      periph.init = true;
+      periph.written = false;
+      periph.rsf.armed = false;
+      arm (&periph.initf, periph.faults.initf_delay);
+    }
+  else if (!init && periph.init)
+    {
+      if (is_set (&periph.initf) && periph.written)
+        {
+          // the calendar restarts with the new values
+          periph.ssr = (int32_t) periph.prediv_s;
+          periph.frac = 0;
+          change (SIM_CALENDAR, periph.sec);
+        }
+      periph.init = false;
+      periph.initf.armed = false;
+      arm (&periph.rsf, periph.faults.rsf_delay);
+    }
+  else if (!(value & RTC_ISR_RSF))
+    {
+      // cleared, set again at the next synchronization
+      arm (&periph.rsf, periph.init ? SIM_STUCK : periph.faults.rsf_delay);
+    }
+}
+
+/**
+ * @brief  Write CR; disabling an alarm or the wake-up timer starts setting
+ *      its write flag, enabling it clears the flag.
+ */
+static void
+write_cr (uint32_t value)
+{
+  uint32_t changed = periph.cr ^ value;
+
+  periph.cr = value;
+  if (changed & RTC_CR_ALRAE)
+    {
+      if (value & RTC_CR_ALRAE)
+        periph.alrawf.armed = false;
+      else
+        arm (&periph.alrawf, periph.faults.wf_delay);
+    }
+  if (changed & RTC_CR_ALRBE)
+    {
+      if (value & RTC_CR_ALRBE)
+        periph.alrbwf.armed = false;
+      else
+        arm (&periph.alrbwf, periph.faults.wf_delay);
+    }
+  if (changed & RTC_CR_WUTE)
+    {
+      if (value & RTC_CR_WUTE)
+        periph.wutwf.armed = false;
+      else
+        arm (&periph.wutwf, periph.faults.wf_delay);
+    }
+}
+
+/**
+ * @brief  Write SHIFTR: delay the clock by SUBFS sub-seconds, after adding
+ *      one second if ADD1S is set; SS[15] must be clear.
+ */
+static void
+write_shiftr (uint32_t value)
+{
+  uint32_t subfs = value & 0x7FFF;
+
+  if (periph.init || subfs > periph.prediv_s)
+    {
+      violation ("invalid shift in", SIM_SHIFTR);
+      return;
+    }
+  if (periph.ssr & 0x8000)
+    {
+      violation ("SS[15] set, shift in", SIM_SHIFTR);
+      return;
+    }
+  periph.ssr += (int32_t) subfs;
+  if (value & RTC_SHIFTADD1S_SET)
+    periph.sec++;
+  change (SIM_SHIFT, value);
+}
+
+sim_reg&
+sim_reg::operator= (uint32_t value)
+{
+  bool initf;
+
+  sim_yield (REG_COST);
+  advance ();
+
+  if (id_ == SIM_WPR)
+    {
+      periph.wpr = (value == 0xCA) ? 1 :
+                   (value == 0x53 && periph.wpr == 1) ? 2 : 0;
+      return *this;
+    }
+  if (id_ == SIM_ISR)
+    {
+      write_isr (value);
+      return *this;
+    }
+  if (periph.wpr != 2)
+    {
+      violation ("write protected", id_);
+      return *this;
+    }
+
+  initf = periph.init && is_set (&periph.initf);
+  switch (id_)
+    {
+    case SIM_TR:
+    case SIM_DR:
+      if (!initf)
+        {
+          violation ("not in init mode, write to", id_);
+          break;
+        }
+      periph.sec = (id_ == SIM_TR) ?
+          decode (value, encode_dr (periph.sec)) :
+          decode (encode_tr (periph.sec), value);
+      periph.written = true;
+      periph.latched = false;
+      periph.time_seq++;
+      break;
+    case SIM_PRER:
+      if (!initf)
+        {
+          violation ("not in init mode, write to", id_);
+          break;
+        }
+      periph.prediv_s = value & RTC_PRER_PREDIV_S;
+      periph.prediv_a = (value & RTC_PRER_PREDIV_A) >> 16;
+      periph.ssr = (int32_t) periph.prediv_s;
+      break;
+    case SIM_CR:
+      write_cr (value);
+      break;
+    case SIM_ALRMAR:
+    case SIM_ALRMASSR:
+      if (!initf && !is_set (&periph.alrawf))
+        {
+          violation ("ALRAWF not set, write to", id_);
+          break;
+        }
+      if (id_ == SIM_ALRMAR)
+        {
+          periph.alrmar = value;
+          change (SIM_ALARM_A, value);
+        }
+      else
+        periph.alrmassr = value;
+      break;
+    case SIM_ALRMBR:
+    case SIM_ALRMBSSR:
+      if (!initf && !is_set (&periph.alrbwf))
+        {
+          violation ("ALRBWF not set, write to", id_);
+          break;
+        }
+      if (id_ == SIM_ALRMBR)
+        {
+          periph.alrmbr = value;
+          change (SIM_ALARM_B, value);
+        }
+      else
+        periph.alrmbssr = value;
+      break;
+    case SIM_WUTR:
+      if (!initf && !is_set (&periph.wutwf))
+        {
+          violation ("WUTWF not set, write to", id_);
+          break;
+        }
+      periph.wutr = value & 0xFFFF;
+      change (SIM_WAKEUP, periph.wutr);
+      break;
+    case SIM_SHIFTR:
+      write_shiftr (value);
+      break;
+    case SIM_CALR:
+      periph.calr = value;
+      break;
+    default:
+      violation ("read only", id_);
+      break;
+    }
+  return *this;
+}
+
+/**
+ * @brief  Reset the peripheral (backup domain).
+ * @param  prediv_s: synchronous prescaler, if already initialized.
+ * @param  now: calendar, if already initialized (e.g. by an earlier
+ *      firmware), or 0 for a backup domain reset.
+ */
+void
+sim_rtc_reset (uint32_t prediv_s, time_t now)
+{
+  memset (&periph, 0, sizeof(periph));
+
+  periph.prediv_s = now ? prediv_s : 0xFF;
+  periph.prediv_a = now ? 0x1F : 0x7F;
+  periph.sec = now ? now : RESET_TIME;
+  periph.ssr = (int32_t) periph.prediv_s;
+  periph.last_us = sim_now ();
+
+  periph.rsf.armed = true;
+  periph.alrawf.armed = true;
+  periph.alrbwf.armed = true;
+  periph.wutwf.armed = true;
+
+  periph.faults.initf_delay = SIM_FLAG_DELAY;
+  periph.faults.wf_delay = SIM_FLAG_DELAY;
+  periph.faults.rsf_delay = SIM_FLAG_DELAY;
+
+  for (int i = 0; i < 32; i++)
+    periph.bkp_writer[i] = -1;
+}
+
+static void
+rearm (flag_t* flag, uint32_t delay)
+{
+  if (flag->armed && flag->at == UINT64_MAX && delay != SIM_STUCK)
+    flag->at = sim_now () + delay;
+}
+
+/**
+ * @brief  Change the injected faults; a stuck flag gets set after the new
+ *      delay.
+ */
+void
+sim_rtc_faults (const sim_faults_t* faults)
+{
+  periph.faults = *faults;
+  rearm (&periph.initf, faults->initf_delay);
+  rearm (&periph.rsf, faults->rsf_delay);
+  rearm (&periph.alrawf, faults->wf_delay);
+  rearm (&periph.alrbwf, faults->wf_delay);
+  rearm (&periph.wutwf, faults->wf_delay);
+}
+
+/**
+ * @brief  Return the calendar time, as the driver computes it.
+ * @return Microseconds since the epoch.
+ */
+int64_t
+sim_rtc_time_us (void)
+{
+  int64_t sec, subsec;
+
+  advance ();
+  sec = periph.sec;
+  subsec = (int64_t) periph.prediv_s - periph.ssr;
+  if (subsec < 0)
+    {
+      subsec += periph.prediv_s + 1;
+      sec--;
+    }
+  return sec * 1000000 + subsec * 1000000 / (periph.prediv_s + 1);
+}
+
+/**
+ * @brief  Return the number of changes made to the peripheral.
+ */
+uint64_t
+sim_rtc_seq (void)
+{
+  return periph.seq;
+}
+
+/**
+ * @brief  Return the number of changes made to the calendar.
+ */
+uint64_t
+sim_rtc_time_seq (void)
+{
+  return periph.time_seq;
+}
+
+/**
+ * @brief  Return the last change of a kind made by the running thread.
+ * @param  what: the kind of change.
+ * @param  since: only changes made after this sequence number count.
+ * @param  value: returns the value written (the calendar time, the shift
+ *      register, the alarm or the wake-up timer register).
+ * @return true if found.
+ */
+bool
+sim_rtc_changed (sim_change_t what, uint64_t since, int64_t* value)
+{
+  change_t* c = &periph.changes[slot ()][what];
+
+  if (c->seq <= since)
+    return false;
+  *value = c->value;
+  return true;
+}
+
+/**
+ * @brief  Return the thread that wrote a backup register last, -1 if none.
+ */
+int
+sim_rtc_bkp_writer (uint32_t reg)
+{
+  return periph.bkp_writer[reg & 31];
+}
+
+/**
+ * @brief  Check that the peripheral was left in a clean state: not in init
+ *      mode, write protected and the shadow registers not locked.
+ */
+bool
+sim_rtc_idle (void)
+{
+  return !periph.init && periph.wpr == 0 && !periph.latched;
+}
+
+uint32_t
+sim_rtc_violations (void)
+{
+  return periph.violations;
+}
+
+uint32_t
+sim_rtc_hal_errors (void)
+{
+  return periph.hal_errors;
+}
+
+// ----- HAL ------------------------------------------------------------------
+
+#define SIM_HAL_LOCK(__HANDLE__) \
+  do \
+    { \
+      if ((__HANDLE__)->Lock == HAL_LOCKED) \
+        return HAL_BUSY; \
+      (__HANDLE__)->Lock = HAL_LOCKED; \
+    } \
+  while (0)
+
+#define SIM_HAL_UNLOCK(__HANDLE__) \
+  do \
+    { \
+      (__HANDLE__)->Lock = HAL_UNLOCKED; \
+    } \
+  while (0)
+
+/**
+ * @brief  Check if a HAL error is injected; the handle is then released.
+ * @return true if the HAL function must fail.
+ */
+static bool
+hal_fault (RTC_HandleTypeDef* hrtc)
+{
+  if (periph.faults.hal_error)
+    {
+      periph.hal_errors++;
+      hrtc->State = HAL_RTC_STATE_ERROR;
+      SIM_HAL_UNLOCK(hrtc);
+      return true;
+    }
+  return false;
+}
+
+/**
+ * @brief  Poll ISR until some flags are set or clear, like the HAL.
+ * @return true if successful, false on timeout.
+ */
+static bool
+wait_isr (RTC_HandleTypeDef* hrtc, uint32_t mask, bool set)
+{
+  uint64_t start = sim_now ();
+
+  while ((hrtc->Instance->ISR & mask) != (set ? mask : 0))
+    {
+      if (sim_now () - start > HAL_TIMEOUT_US)
+        return false;
+      sim_spin (SPIN_US);
+    }
+  return true;
+}
+
+static HAL_StatusTypeDef
+enter_init_mode (RTC_HandleTypeDef* hrtc)
+{
+  if ((hrtc->Instance->ISR & RTC_ISR_INITF) == 0)
+    {
+      hrtc->Instance->ISR = (uint32_t) RTC_INIT_MASK;
+      if (!wait_isr (hrtc, RTC_ISR_INITF, true))
+        return HAL_TIMEOUT;
+    }
+  return HAL_OK;
+}
+
+static HAL_StatusTypeDef
+wait_for_synchro (RTC_HandleTypeDef* hrtc)
+{
+  hrtc->Instance->ISR &= (uint32_t) RTC_RSF_MASK;
+  if (!wait_isr (hrtc, RTC_ISR_RSF, true))
+    return HAL_TIMEOUT;
+  return HAL_OK;
+}
+
+uint8_t
+RTC_ByteToBcd2 (uint8_t value)
+{
+  uint32_t bcdhigh = 0;
+
+  while (value >= 10)
+    {
+      bcdhigh++;
+      value -= 10;
+    }
+  return (uint8_t) (bcdhigh << 4) | value;
+}
+
+static uint8_t
+RTC_Bcd2ToByte (uint8_t value)
+{
+  return (uint8_t) bin (value);
+}
+
+HAL_StatusTypeDef
+HAL_RCC_OscConfig (RCC_OscInitTypeDef* init __attribute__ ((unused)))
+{
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_RCCEx_PeriphCLKConfig (
+    RCC_PeriphCLKInitTypeDef* init __attribute__ ((unused)))
+{
+  return HAL_OK;
+}
+
+void
+HAL_NVIC_SetPriority (IRQn_Type irqn __attribute__ ((unused)),
+                      uint32_t preempt __attribute__ ((unused)),
+                      uint32_t sub __attribute__ ((unused)))
+{
+}
+
+void
+HAL_NVIC_EnableIRQ (IRQn_Type irqn __attribute__ ((unused)))
+{
+}
+
+void
+HAL_NVIC_DisableIRQ (IRQn_Type irqn __attribute__ ((unused)))
+{
+}
+
+HAL_StatusTypeDef
+HAL_RTC_Init (RTC_HandleTypeDef* hrtc)
+{
+  sim_yield (HAL_COST);
+  if (hrtc == nullptr || hal_fault (hrtc))
+    return HAL_ERROR;
+
+  if (hrtc->State == HAL_RTC_STATE_RESET)
+    hrtc->Lock = HAL_UNLOCKED;
+  hrtc->State = HAL_RTC_STATE_BUSY;
+
+  __HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+  if (enter_init_mode (hrtc) != HAL_OK)
+    {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+      hrtc->State = HAL_RTC_STATE_ERROR;
+      return HAL_ERROR;
+    }
+  hrtc->Instance->CR &= ~(RTC_CR_FMT | RTC_CR_OSEL | RTC_CR_POL);
+  hrtc->Instance->CR |= hrtc->Init.HourFormat | hrtc->Init.OutPut
+      | hrtc->Init.OutPutPolarity;
+  hrtc->Instance->PRER = hrtc->Init.SynchPrediv
+      | (hrtc->Init.AsynchPrediv << 16);
+  hrtc->Instance->ISR &= ~RTC_ISR_INIT;
+  __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+  hrtc->State = HAL_RTC_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_RTC_DeInit (RTC_HandleTypeDef* hrtc)
+{
+  sim_yield (HAL_COST);
+  if (hal_fault (hrtc))
+    return HAL_ERROR;
+
+  hrtc->State = HAL_RTC_STATE_BUSY;
+  __HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+  if (enter_init_mode (hrtc) != HAL_OK)
+    {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+      hrtc->State = HAL_RTC_STATE_TIMEOUT;
+      return HAL_TIMEOUT;
+    }
+  hrtc->Instance->TR = 0;
+  hrtc->Instance->DR = 0x00002101U;
+  hrtc->Instance->CR = 0;
+  hrtc->Instance->WUTR = 0xFFFFU;
+  hrtc->Instance->PRER = 0x007F00FFU;
+  hrtc->Instance->ALRMAR = 0;
+  hrtc->Instance->ALRMBR = 0;
+  hrtc->Instance->CALR = 0;
+  hrtc->Instance->ISR = 0;
+  __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+  hrtc->State = HAL_RTC_STATE_RESET;
+  SIM_HAL_UNLOCK(hrtc);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_RTC_SetTime (RTC_HandleTypeDef* hrtc, RTC_TimeTypeDef* time,
+                 uint32_t format)
+{
+  uint32_t tmpreg;
+
+  sim_yield (HAL_COST);
+  SIM_HAL_LOCK(hrtc);
+  if (hal_fault (hrtc))
+    return HAL_ERROR;
+  hrtc->State = HAL_RTC_STATE_BUSY;
+
+  if (format == FORMAT_BIN)
+    tmpreg = ((uint32_t) RTC_ByteToBcd2 (time->Hours) << 16)
+        | ((uint32_t) RTC_ByteToBcd2 (time->Minutes) << 8)
+        | ((uint32_t) RTC_ByteToBcd2 (time->Seconds))
+        | ((uint32_t) time->TimeFormat << 16);
+  else
+    tmpreg = ((uint32_t) time->Hours << 16) | ((uint32_t) time->Minutes << 8)
+        | ((uint32_t) time->Seconds) | ((uint32_t) time->TimeFormat << 16);
+
+  __HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+  if (enter_init_mode (hrtc) != HAL_OK)
+    {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+      hrtc->State = HAL_RTC_STATE_ERROR;
+      SIM_HAL_UNLOCK(hrtc);
+      return HAL_ERROR;
+    }
+  hrtc->Instance->TR = tmpreg & RTC_TR_RESERVED_MASK;
+  hrtc->Instance->CR &= ~RTC_CR_BKP;
+  hrtc->Instance->CR |= time->DayLightSaving | time->StoreOperation;
+  hrtc->Instance->ISR &= ~RTC_ISR_INIT;
+  if ((hrtc->Instance->CR & RTC_CR_BYPSHAD) == 0
+      && wait_for_synchro (hrtc) != HAL_OK)
+    {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+      hrtc->State = HAL_RTC_STATE_ERROR;
+      SIM_HAL_UNLOCK(hrtc);
+      return HAL_ERROR;
+    }
+  __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+  hrtc->State = HAL_RTC_STATE_READY;
+  SIM_HAL_UNLOCK(hrtc);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_RTC_GetTime (RTC_HandleTypeDef* hrtc, RTC_TimeTypeDef* time,
+                 uint32_t format)
+{
+  uint32_t tmpreg;
+
+  sim_yield (HAL_COST);
+
+  time->SubSeconds = hrtc->Instance->SSR;
+  time->SecondFraction = hrtc->Instance->PRER & RTC_PRER_PREDIV_S;
+  tmpreg = hrtc->Instance->TR & RTC_TR_RESERVED_MASK;
+
+  time->Hours = (uint8_t) ((tmpreg & 0x3F0000U) >> 16);
+  time->Minutes = (uint8_t) ((tmpreg & 0x7F00U) >> 8);
+  time->Seconds = (uint8_t) (tmpreg & 0x7FU);
+  time->TimeFormat = (uint8_t) ((tmpreg & 0x400000U) >> 16);
+
+  if (format == FORMAT_BIN)
+    {
+      time->Hours = RTC_Bcd2ToByte (time->Hours);
+      time->Minutes = RTC_Bcd2ToByte (time->Minutes);
+      time->Seconds = RTC_Bcd2ToByte (time->Seconds);
+    }
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_RTC_SetDate (RTC_HandleTypeDef* hrtc, RTC_DateTypeDef* date,
+                 uint32_t format)
+{
+  uint32_t tmpreg;
+
+  sim_yield (HAL_COST);
+  SIM_HAL_LOCK(hrtc);
+  if (hal_fault (hrtc))
+    return HAL_ERROR;
+  hrtc->State = HAL_RTC_STATE_BUSY;
+
+  if (format == FORMAT_BIN)
+    tmpreg = ((uint32_t) RTC_ByteToBcd2 (date->Year) << 16)
+        | ((uint32_t) RTC_ByteToBcd2 (date->Month) << 8)
+        | ((uint32_t) RTC_ByteToBcd2 (date->Date))
+        | ((uint32_t) date->WeekDay << 13);
+  else
+    tmpreg = ((uint32_t) date->Year << 16) | ((uint32_t) date->Month << 8)
+        | ((uint32_t) date->Date) | ((uint32_t) date->WeekDay << 13);
+
+  __HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+  if (enter_init_mode (hrtc) != HAL_OK)
+    {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+      hrtc->State = HAL_RTC_STATE_ERROR;
+      SIM_HAL_UNLOCK(hrtc);
+      return HAL_ERROR;
+    }
+  hrtc->Instance->DR = tmpreg & RTC_DR_RESERVED_MASK;
+  hrtc->Instance->ISR &= ~RTC_ISR_INIT;
+  if ((hrtc->Instance->CR & RTC_CR_BYPSHAD) == 0
+      && wait_for_synchro (hrtc) != HAL_OK)
+    {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+      hrtc->State = HAL_RTC_STATE_ERROR;
+      SIM_HAL_UNLOCK(hrtc);
+      return HAL_ERROR;
+    }
+  __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+  hrtc->State = HAL_RTC_STATE_READY;
+  SIM_HAL_UNLOCK(hrtc);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_RTC_GetDate (RTC_HandleTypeDef* hrtc, RTC_DateTypeDef* date,
+                 uint32_t format)
+{
+  uint32_t tmpreg;
+
+  sim_yield (HAL_COST);
+
+  tmpreg = hrtc->Instance->DR & RTC_DR_RESERVED_MASK;
+  date->Year = (uint8_t) ((tmpreg & 0xFF0000U) >> 16);
+  date->Month = (uint8_t) ((tmpreg & 0x1F00U) >> 8);
+  date->Date = (uint8_t) (tmpreg & 0x3FU);
+  date->WeekDay = (uint8_t) ((tmpreg & 0xE000U) >> 13);
+
+  if (format == FORMAT_BIN)
+    {
+      date->Year = RTC_Bcd2ToByte (date->Year);
+      date->Month = RTC_Bcd2ToByte (date->Month);
+      date->Date = RTC_Bcd2ToByte (date->Date);
+    }
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_RTC_SetAlarm_IT (RTC_HandleTypeDef* hrtc, RTC_AlarmTypeDef* alarm,
+                     uint32_t format)
+{
+  uint32_t tmpreg, subsecond;
+  bool a = (alarm->Alarm == RTC_ALARM_A);
+
+  sim_yield (HAL_COST);
+  SIM_HAL_LOCK(hrtc);
+  if (hal_fault (hrtc))
+    return HAL_ERROR;
+  hrtc->State = HAL_RTC_STATE_BUSY;
+
+  if (format == FORMAT_BIN)
+    tmpreg = ((uint32_t) RTC_ByteToBcd2 (alarm->AlarmTime.Hours) << 16)
+        | ((uint32_t) RTC_ByteToBcd2 (alarm->AlarmTime.Minutes) << 8)
+        | ((uint32_t) RTC_ByteToBcd2 (alarm->AlarmTime.Seconds))
+        | ((uint32_t) alarm->AlarmTime.TimeFormat << 16)
+        | ((uint32_t) RTC_ByteToBcd2 (alarm->AlarmDateWeekDay) << 24)
+        | alarm->AlarmDateWeekDaySel | alarm->AlarmMask;
+  else
+    tmpreg = ((uint32_t) alarm->AlarmTime.Hours << 16)
+        | ((uint32_t) alarm->AlarmTime.Minutes << 8)
+        | ((uint32_t) alarm->AlarmTime.Seconds)
+        | ((uint32_t) alarm->AlarmTime.TimeFormat << 16)
+        | ((uint32_t) alarm->AlarmDateWeekDay << 24)
+        | alarm->AlarmDateWeekDaySel | alarm->AlarmMask;
+  subsecond = alarm->AlarmTime.SubSeconds | alarm->AlarmSubSecondMask;
+
+  __HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+  if (a)
+    {
+      __HAL_RTC_ALARMA_DISABLE(hrtc);
+      __HAL_RTC_ALARM_CLEAR_FLAG(hrtc, RTC_FLAG_ALRAF);
+    }
+  else
+    {
+      __HAL_RTC_ALARMB_DISABLE(hrtc);
+      __HAL_RTC_ALARM_CLEAR_FLAG(hrtc, RTC_FLAG_ALRBF);
+    }
+  if (!wait_isr (hrtc, a ? RTC_ISR_ALRAWF : RTC_ISR_ALRBWF, true))
+    {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+      hrtc->State = HAL_RTC_STATE_TIMEOUT;
+      SIM_HAL_UNLOCK(hrtc);
+      return HAL_TIMEOUT;
+    }
+  if (a)
+    {
+      hrtc->Instance->ALRMAR = tmpreg;
+      hrtc->Instance->ALRMASSR = subsecond;
+      __HAL_RTC_ALARMA_ENABLE(hrtc);
+      __HAL_RTC_ALARM_ENABLE_IT(hrtc, RTC_IT_ALRA);
+    }
+  else
+    {
+      hrtc->Instance->ALRMBR = tmpreg;
+      hrtc->Instance->ALRMBSSR = subsecond;
+      __HAL_RTC_ALARMB_ENABLE(hrtc);
+      __HAL_RTC_ALARM_ENABLE_IT(hrtc, RTC_IT_ALRB);
+    }
+  __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+  hrtc->State = HAL_RTC_STATE_READY;
+  SIM_HAL_UNLOCK(hrtc);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_RTC_DeactivateAlarm (RTC_HandleTypeDef* hrtc, uint32_t alarm)
+{
+  bool a = (alarm == RTC_ALARM_A);
+
+  sim_yield (HAL_COST);
+  SIM_HAL_LOCK(hrtc);
+  if (hal_fault (hrtc))
+    return HAL_ERROR;
+  hrtc->State = HAL_RTC_STATE_BUSY;
+
+  __HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+  if (a)
+    {
+      __HAL_RTC_ALARMA_DISABLE(hrtc);
+      __HAL_RTC_ALARM_DISABLE_IT(hrtc, RTC_IT_ALRA);
+    }
+  else
+    {
+      __HAL_RTC_ALARMB_DISABLE(hrtc);
+      __HAL_RTC_ALARM_DISABLE_IT(hrtc, RTC_IT_ALRB);
+    }
+  if (!wait_isr (hrtc, a ? RTC_ISR_ALRAWF : RTC_ISR_ALRBWF, true))
+    {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+      hrtc->State = HAL_RTC_STATE_TIMEOUT;
+      SIM_HAL_UNLOCK(hrtc);
+      return HAL_TIMEOUT;
+    }
+  __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+  hrtc->State = HAL_RTC_STATE_READY;
+  SIM_HAL_UNLOCK(hrtc);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_RTC_GetAlarm (RTC_HandleTypeDef* hrtc, RTC_AlarmTypeDef* alarm,
+                  uint32_t which, uint32_t format)
+{
+  uint32_t tmpreg, subsecond;
+
+  sim_yield (HAL_COST);
+
+  if (which == RTC_ALARM_A)
+    {
+      tmpreg = hrtc->Instance->ALRMAR;
+      subsecond = hrtc->Instance->ALRMASSR & 0x7FFFU;
+    }
+  else
+    {
+      tmpreg = hrtc->Instance->ALRMBR;
+      subsecond = hrtc->Instance->ALRMBSSR & 0x7FFFU;
+    }
+
+  alarm->Alarm = which;
+  alarm->AlarmTime.Hours = (uint8_t) ((tmpreg & 0x3F0000U) >> 16);
+  alarm->AlarmTime.Minutes = (uint8_t) ((tmpreg & 0x7F00U) >> 8);
+  alarm->AlarmTime.Seconds = (uint8_t) (tmpreg & 0x7FU);
+  alarm->AlarmTime.TimeFormat = (uint8_t) ((tmpreg & 0x400000U) >> 16);
+  alarm->AlarmTime.SubSeconds = subsecond;
+  alarm->AlarmDateWeekDay = (uint8_t) ((tmpreg & 0x3F000000U) >> 24);
+  alarm->AlarmDateWeekDaySel = tmpreg & RTC_ALRMAR_WDSEL;
+  alarm->AlarmMask = tmpreg
+      & (RTC_ALRMAR_MSK4 | RTC_ALRMAR_MSK3 | RTC_ALRMAR_MSK2 | RTC_ALRMAR_MSK1);
+
+  if (format == FORMAT_BIN)
+    {
+      alarm->AlarmTime.Hours = RTC_Bcd2ToByte (alarm->AlarmTime.Hours);
+      alarm->AlarmTime.Minutes = RTC_Bcd2ToByte (alarm->AlarmTime.Minutes);
+      alarm->AlarmTime.Seconds = RTC_Bcd2ToByte (alarm->AlarmTime.Seconds);
+      alarm->AlarmDateWeekDay = RTC_Bcd2ToByte (alarm->AlarmDateWeekDay);
+    }
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_RTCEx_SetSynchroShift (RTC_HandleTypeDef* hrtc, uint32_t add1s,
+                           uint32_t subfs)
+{
+  sim_yield (HAL_COST);
+  SIM_HAL_LOCK(hrtc);
+  if (hal_fault (hrtc))
+    return HAL_ERROR;
+  hrtc->State = HAL_RTC_STATE_BUSY;
+
+  __HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+  if (!wait_isr (hrtc, RTC_ISR_SHPF, false))
+    {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+      hrtc->State = HAL_RTC_STATE_TIMEOUT;
+      SIM_HAL_UNLOCK(hrtc);
+      return HAL_TIMEOUT;
+    }
+  hrtc->Instance->SHIFTR = subfs | add1s;
+  if ((hrtc->Instance->CR & RTC_CR_BYPSHAD) == 0
+      && wait_for_synchro (hrtc) != HAL_OK)
+    {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+      hrtc->State = HAL_RTC_STATE_ERROR;
+      SIM_HAL_UNLOCK(hrtc);
+      return HAL_ERROR;
+    }
+  __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+  hrtc->State = HAL_RTC_STATE_READY;
+  SIM_HAL_UNLOCK(hrtc);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_RTCEx_SetSmoothCalib (RTC_HandleTypeDef* hrtc, uint32_t period,
+                          uint32_t plus_pulses, uint32_t minus_pulses)
+{
+  sim_yield (HAL_COST);
+  SIM_HAL_LOCK(hrtc);
+  if (hal_fault (hrtc))
+    return HAL_ERROR;
+  hrtc->State = HAL_RTC_STATE_BUSY;
+
+  __HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+  hrtc->Instance->CALR = period | plus_pulses | minus_pulses;
+  __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+  hrtc->State = HAL_RTC_STATE_READY;
+  SIM_HAL_UNLOCK(hrtc);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_RTCEx_SetWakeUpTimer_IT (RTC_HandleTypeDef* hrtc, uint32_t counter,
+                             uint32_t clock)
+{
+  sim_yield (HAL_COST);
+  SIM_HAL_LOCK(hrtc);
+  if (hal_fault (hrtc))
+    return HAL_ERROR;
+  hrtc->State = HAL_RTC_STATE_BUSY;
+
+  __HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+  hrtc->Instance->CR &= ~RTC_CR_WUTE;
+  if (!wait_isr (hrtc, RTC_ISR_WUTWF, true))
+    {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+      hrtc->State = HAL_RTC_STATE_TIMEOUT;
+      SIM_HAL_UNLOCK(hrtc);
+      return HAL_TIMEOUT;
+    }
+  hrtc->Instance->WUTR = counter;
+  hrtc->Instance->CR &= ~RTC_CR_WUCKSEL;
+  hrtc->Instance->CR |= clock;
+  hrtc->Instance->CR |= RTC_CR_WUTIE;
+  hrtc->Instance->CR |= RTC_CR_WUTE;
+  __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+  hrtc->State = HAL_RTC_STATE_READY;
+  SIM_HAL_UNLOCK(hrtc);
+  return HAL_OK;
+}
+
+uint32_t
+HAL_RTCEx_DeactivateWakeUpTimer (RTC_HandleTypeDef* hrtc)
+{
+  sim_yield (HAL_COST);
+  SIM_HAL_LOCK(hrtc);
+  if (hal_fault (hrtc))
+    return HAL_ERROR;
+  hrtc->State = HAL_RTC_STATE_BUSY;
+
+  __HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+  hrtc->Instance->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+  if (!wait_isr (hrtc, RTC_ISR_WUTWF, true))
+    {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+      hrtc->State = HAL_RTC_STATE_TIMEOUT;
+      SIM_HAL_UNLOCK(hrtc);
+      return HAL_TIMEOUT;
+    }
+  __HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+  hrtc->State = HAL_RTC_STATE_READY;
+  SIM_HAL_UNLOCK(hrtc);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_RTCEx_DeactivateTamper (RTC_HandleTypeDef* hrtc __attribute__ ((unused)),
+                            uint32_t tamper __attribute__ ((unused)))
+{
+  sim_yield (HAL_COST);
+  return HAL_OK;
+}
+
+uint32_t
+HAL_RTCEx_BKUPRead (RTC_HandleTypeDef* hrtc __attribute__ ((unused)),
+                    uint32_t reg)
+{
+  sim_yield (REG_COST);
+  return periph.bkp[reg & 31];
+}
+
+void
+HAL_RTCEx_BKUPWrite (RTC_HandleTypeDef* hrtc __attribute__ ((unused)),
+                     uint32_t reg, uint32_t data)
+{
+  sim_yield (REG_COST);
+  periph.bkp[reg & 31] = data;
+  periph.bkp_writer[reg & 31] = slot ();
+}
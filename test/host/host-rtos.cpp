@@ -0,0 +1,454 @@
+/*
+ * host-rtos.cpp
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Simulated scheduler and µOS++ API. Each simulated thread is a host thread,
+ * but only the one holding the baton runs; the others wait on their own
+ * condition variable. At a preemption point the running thread may pass
+ * the baton to another ready thread of the highest priority, chosen by the
+ * seeded generator. When no thread is ready, the simulated time jumps to
+ * the next wake-up.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include <cmsis-plus/rtos/os.h>
+#include "host-sim.h"
+
+using namespace os;
+
+// a preemption point switches threads once in so many times
+static constexpr uint32_t PREEMPT_RATE = 8;
+
+// simulated duration of a mutex operation, us
+static constexpr uint32_t MUTEX_COST = 1;
+
+// preemption points without the time advancing, a thread spins forever
+static constexpr uint32_t SPIN_LIMIT = 1000000;
+
+typedef struct
+{
+  std::thread th;
+  std::condition_variable cv;
+  void*
+  (*func) (void*);
+  void* arg;
+  int priority;
+  uint64_t wake_us;             // ready from this time on
+  rtos::mutex* waiting;         // or when this mutex is released
+  bool finished;
+} sim_thread_t;
+
+static std::mutex baton_lock;
+static std::condition_variable main_cv;
+static sim_thread_t threads[SIM_MAX_THREADS];
+static int thread_count;
+static int current = -1;
+static bool running;
+
+static uint64_t now_us;
+static uint32_t random_state = 1;
+static int irq_nesting;
+static uint32_t switch_count;
+static uint64_t spin_us;
+static uint32_t spin_count;
+
+rtos::clock_systick rtos::sysclock;
+
+/**
+ * @brief  Simple xorshift generator, the scheduling is repeatable.
+ * @return A new pseudo-random value.
+ */
+static uint32_t
+next_random (void)
+{
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+/**
+ * @brief  Check if a thread can run.
+ */
+static bool
+ready (sim_thread_t* t)
+{
+  return !t->finished
+      && (now_us >= t->wake_us
+          || (t->waiting != nullptr && t->waiting->owner_ < 0));
+}
+
+/**
+ * @brief  Choose the next thread to run, among the ready threads of the
+ *      highest priority, advancing the time if none is ready.
+ * @return The thread, or -1 if all threads finished.
+ */
+static int
+pick (void)
+{
+  int candidates[SIM_MAX_THREADS];
+  int n, priority;
+  uint64_t wake;
+  bool alive;
+
+  for (;;)
+    {
+      n = 0;
+      priority = INT32_MIN;
+      wake = UINT64_MAX;
+      alive = false;
+      for (int i = 0; i < thread_count; i++)
+        {
+          if (threads[i].finished)
+            continue;
+          alive = true;
+          if (ready (&threads[i]))
+            {
+              if (threads[i].priority > priority)
+                {
+                  priority = threads[i].priority;
+                  n = 0;
+                }
+              if (threads[i].priority == priority)
+                candidates[n++] = i;
+            }
+          else if (threads[i].wake_us < wake)
+            wake = threads[i].wake_us;
+        }
+      if (n)
+        return candidates[next_random () % n];
+      if (!alive)
+        return -1;
+      if (wake == UINT64_MAX)
+        {
+          fprintf (stderr, "sim: deadlock, all threads blocked forever\n");
+          abort ();
+        }
+      now_us = wake;
+    }
+}
+
+/**
+ * @brief  Check if a ready thread has a higher priority than the running
+ *      one; it then runs at once, like with a real scheduler.
+ */
+static bool
+preempted (void)
+{
+  for (int i = 0; i < thread_count; i++)
+    {
+      if (ready (&threads[i])
+          && threads[i].priority > threads[current].priority)
+        return true;
+    }
+  return false;
+}
+
+/**
+ * @brief  Pass the baton to a thread, then wait to get it back (unless the
+ *      calling thread finished).
+ * @param  next: the thread to run, -1 to return to the main thread.
+ */
+static void
+switch_to (int next)
+{
+  std::unique_lock<std::mutex> lock
+    { baton_lock };
+  int self = current;
+
+  if (next == self)
+    return;
+
+  current = next;
+  switch_count++;
+  if (next >= 0)
+    threads[next].cv.notify_one ();
+  else
+    main_cv.notify_one ();
+
+  if (self >= 0 && !threads[self].finished)
+    threads[self].cv.wait (lock, [self]
+      { return current == self;});
+}
+
+/**
+ * @brief  Body of the host threads: wait for the baton, run the function.
+ * @param  id: the thread.
+ */
+static void
+entry (int id)
+{
+  sim_thread_t* t = &threads[id];
+
+    {
+      std::unique_lock<std::mutex> lock
+        { baton_lock };
+      t->cv.wait (lock, [id]
+        { return current == id;});
+    }
+
+  t->func (t->arg);
+  t->finished = true;
+  switch_to (pick ());
+}
+
+/**
+ * @brief  Forget all threads and restart the simulated time.
+ * @param  seed: seed of the scheduling decisions.
+ */
+void
+sim_reset (uint32_t seed)
+{
+  for (int i = 0; i < thread_count; i++)
+    {
+      if (threads[i].th.joinable ())
+        threads[i].th.join ();
+    }
+  thread_count = 0;
+  current = -1;
+  running = false;
+  now_us = 0;
+  random_state = seed ? seed : 1;
+  irq_nesting = 0;
+  switch_count = 0;
+  spin_us = 0;
+  spin_count = 0;
+}
+
+/**
+ * @brief  Create a thread; it starts running with sim_run ().
+ * @param  func: thread function.
+ * @param  arg: its argument.
+ * @param  priority: the ready threads of the highest priority run.
+ * @return The thread number.
+ */
+int
+sim_spawn (void* (*func) (void*), void* arg, int priority)
+{
+  int id = thread_count;
+  sim_thread_t* t = &threads[id];
+
+  if (id >= SIM_MAX_THREADS)
+    {
+      fprintf (stderr, "sim: too many threads\n");
+      abort ();
+    }
+  thread_count++;
+  t->func = func;
+  t->arg = arg;
+  t->priority = priority;
+  t->wake_us = 0;
+  t->waiting = nullptr;
+  t->finished = false;
+  t->th = std::thread (entry, id);
+  return id;
+}
+
+/**
+ * @brief  Run the threads until all of them return.
+ */
+void
+sim_run (void)
+{
+  int next;
+
+  running = true;
+  next = pick ();
+  if (next >= 0)
+    {
+      switch_to (next);
+
+      std::unique_lock<std::mutex> lock
+        { baton_lock };
+      main_cv.wait (lock, []
+        { return current < 0;});
+    }
+  running = false;
+
+  for (int i = 0; i < thread_count; i++)
+    threads[i].th.join ();
+  thread_count = 0;
+}
+
+/**
+ * @brief  Return the running thread, -1 outside sim_run ().
+ */
+int
+sim_self (void)
+{
+  return running ? current : -1;
+}
+
+/**
+ * @brief  Return the simulated time, in microseconds.
+ */
+uint64_t
+sim_now (void)
+{
+  return now_us;
+}
+
+/**
+ * @brief  Preemption point: let the time pass, then switch threads if one
+ *      of a higher priority is ready, or maybe to one of the same priority
+ *      (not in critical sections).
+ * @param  cost_us: duration of the operation just done.
+ */
+void
+sim_yield (uint32_t cost_us)
+{
+  now_us += cost_us;
+  if (now_us != spin_us)
+    {
+      spin_us = now_us;
+      spin_count = 0;
+    }
+  else if (++spin_count > SPIN_LIMIT)
+    {
+      fprintf (stderr, "sim: livelock, the time stands still\n");
+      abort ();
+    }
+  if (!running || irq_nesting)
+    return;
+  if (preempted () || next_random () % PREEMPT_RATE == 0)
+    switch_to (pick ());
+}
+
+/**
+ * @brief  Busy wait; the other threads run meanwhile (time slicing).
+ * @param  us: duration of the wait.
+ */
+void
+sim_spin (uint32_t us)
+{
+  sim_sleep_until (now_us + us);
+}
+
+/**
+ * @brief  Block the running thread until a given time.
+ * @param  wake_us: the time, in microseconds.
+ */
+void
+sim_sleep_until (uint64_t wake_us)
+{
+  if (!running)
+    {
+      if (wake_us > now_us)
+        now_us = wake_us;
+      return;
+    }
+
+  threads[current].wake_us = wake_us;
+  switch_to (pick ());
+  threads[current].wake_us = 0;
+}
+
+/**
+ * @brief  Return the number of thread switches since the reset.
+ */
+uint32_t
+sim_switches (void)
+{
+  return switch_count;
+}
+
+// ----- µOS++ ----------------------------------------------------------------
+
+rtos::clock::timestamp_t
+rtos::clock_systick::now (void)
+{
+  return now_us * frequency_hz / 1000000;
+}
+
+rtos::result_t
+rtos::clock_systick::sleep_for (duration_t duration)
+{
+  sim_sleep_until ((now () + duration) * 1000000 / frequency_hz);
+  return result::ok;
+}
+
+rtos::mutex::mutex (const char* name __attribute__ ((unused)))
+{
+}
+
+rtos::result_t
+rtos::mutex::lock (void)
+{
+  return timed_lock (UINT32_MAX);
+}
+
+rtos::result_t
+rtos::mutex::timed_lock (clock::duration_t timeout)
+{
+  uint64_t deadline = UINT64_MAX;
+  int self = running ? current : SIM_MAX_THREADS;
+
+  sim_yield (MUTEX_COST);
+  if (timeout != UINT32_MAX)
+    deadline = now_us + (uint64_t) timeout * 1000000 / sysclock.frequency_hz;
+
+  while (owner_ >= 0)
+    {
+      if (!running || now_us >= deadline)
+        return result::etimedout;
+
+      threads[self].waiting = this;
+      threads[self].wake_us = deadline;
+      switch_to (pick ());
+      threads[self].waiting = nullptr;
+      threads[self].wake_us = 0;
+    }
+  owner_ = self;
+  return result::ok;
+}
+
+rtos::result_t
+rtos::mutex::unlock (void)
+{
+  owner_ = -1;
+  sim_yield (MUTEX_COST);
+  return result::ok;
+}
+
+rtos::interrupts::critical_section::critical_section ()
+{
+  irq_nesting++;
+}
+
+rtos::interrupts::critical_section::~critical_section ()
+{
+  // the pending interrupts and the woken threads run on leaving it
+  if (--irq_nesting == 0)
+    sim_yield (0);
+}
@@ -0,0 +1,145 @@
+/*
+ * host-sim.h
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Host simulation of the STM32F7 RTC peripheral and of the µOS++ scheduler,
+ * used to run the real driver on Linux.
+ *
+ * The scheduler runs the threads one at a time, like on a single core,
+ * and switches between them at the simulated preemption points (register
+ * accesses, HAL calls, mutexes, sleeps, the end of critical sections);
+ * which thread runs next is drawn from a seeded generator, so a run is
+ * exactly repeatable. The time is simulated too, in microseconds.
+ *
+ * The peripheral models the calendar, the init mode, the shadow registers,
+ * the alarm and wake-up timer write flags, the sub-second shift and the
+ * write protection. Faults can be injected: slow or stuck INITF, ALRxWF,
+ * WUTWF and RSF flags (the HAL functions then fail with HAL_TIMEOUT or
+ * HAL_ERROR after their 1 s timeout) and HAL_ERROR returns. Every access
+ * that breaks a rule of the reference manual is counted as a violation.
+ */
+
+#ifndef TEST_HOST_HOST_SIM_H_
+#define TEST_HOST_HOST_SIM_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined (__cplusplus)
+
+// ----- Scheduler --------------------------------------------------------------
+
+static constexpr int SIM_MAX_THREADS = 16;
+
+void
+sim_reset (uint32_t seed);
+
+int
+sim_spawn (void* (*func) (void*), void* arg, int priority = 0);
+
+void
+sim_run (void);
+
+int
+sim_self (void);
+
+uint64_t
+sim_now (void);
+
+void
+sim_yield (uint32_t cost_us);
+
+void
+sim_spin (uint32_t us);
+
+void
+sim_sleep_until (uint64_t wake_us);
+
+uint32_t
+sim_switches (void);
+
+// ----- Peripheral -------------------------------------------------------------
+
+// delay of the flags set by the hardware (2 RTCCLK cycles), us
+static constexpr uint32_t SIM_FLAG_DELAY = 61;
+
+// the flag is never set
+static constexpr uint32_t SIM_STUCK = UINT32_MAX;
+
+typedef struct
+{
+  uint32_t initf_delay;         // INITF, after INIT is set, us
+  uint32_t wf_delay;            // ALRAWF, ALRBWF and WUTWF, us
+  uint32_t rsf_delay;           // RSF, after it is cleared, us
+  bool hal_error;               // the HAL functions fail with HAL_ERROR
+} sim_faults_t;
+
+typedef enum
+{
+  SIM_CALENDAR,                 // init mode left after writing TR or DR
+  SIM_SHIFT,                    // SHIFTR written
+  SIM_ALARM_A,                  // ALRMAR written
+  SIM_ALARM_B,                  // ALRMBR written
+  SIM_WAKEUP,                   // WUTR written
+  SIM_CHANGES
+} sim_change_t;
+
+void
+sim_rtc_reset (uint32_t prediv_s, time_t now);
+
+void
+sim_rtc_faults (const sim_faults_t* faults);
+
+int64_t
+sim_rtc_time_us (void);
+
+uint64_t
+sim_rtc_seq (void);
+
+uint64_t
+sim_rtc_time_seq (void);
+
+bool
+sim_rtc_changed (sim_change_t change, uint64_t since, int64_t* value);
+
+int
+sim_rtc_bkp_writer (uint32_t reg);
+
+bool
+sim_rtc_idle (void);
+
+uint32_t
+sim_rtc_violations (void);
+
+uint32_t
+sim_rtc_hal_errors (void);
+
+#endif // (__cplusplus)
+
+#endif /* TEST_HOST_HOST_SIM_H_ */
@@ -0,0 +1,73 @@
+/*
+ * host-test.h
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Helpers shared by the host tests: the check macro, which counts the
+ * failures instead of stopping, and the pseudo-random generator, so the
+ * runs are repeatable from a seed.
+ */
+
+#ifndef TEST_HOST_HOST_TEST_H_
+#define TEST_HOST_HOST_TEST_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#if defined (__cplusplus)
+
+static int failures;
+
+#define CHECK(cond) \
+  do \
+    { \
+      if (!(cond)) \
+        { \
+          printf ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+          failures++; \
+        } \
+    } \
+  while (0)
+
+/**
+ * @brief  Simple xorshift generator, the runs are repeatable from a seed.
+ * @param  state: generator state, must not be zero.
+ * @return A new pseudo-random value.
+ */
+static inline uint32_t
+next_random (uint32_t& state)
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+#endif // (__cplusplus)
+
+#endif /* TEST_HOST_HOST_TEST_H_ */
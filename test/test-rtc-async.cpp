@@ -0,0 +1,467 @@
+/*
+ * test-rtc-async.cpp
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Test of the asynchronous operations of the driver: completion, callback,
+ * polling, busy while pending and timeout. It runs on a host (Linux, macOS),
+ * the driver being built against the simulated peripheral in the host
+ * folder:
+ *
+ *   g++ -std=c++11 -O2 -Wall -pthread -I../src -Ihost test-rtc-async.cpp \
+ *       host/host-rtc.cpp host/host-rtos.cpp ../src/rtc-drv.cpp \
+ *       -o test-rtc-async
+ *   ./test-rtc-async
+ *
+ * The program exits with a non-zero status if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <new>
+
+#include "cmsis_device.h"
+#include <cmsis-plus/rtos/os.h>
+#include "rtc-drv.h"
+#include "host-sim.h"
+#include "host-test.h"
+
+#define START_TIME 1700000000   // 2023-11-14 22:13:20 UTC
+
+// duration of the asynchronous timeout, 1 s, us
+static constexpr uint64_t ASYNC_TIMEOUT_US = 1000000;
+
+using namespace os;
+
+typedef struct
+{
+  int calls;
+  rtc::rtc_result_t result;
+  int thread;                   // that called the completion function
+} completions_t;
+
+typedef struct
+{
+  time_t t;
+  completions_t completions;    // of the request waited for
+  completions_t stale;          // of the next one in the same storage
+  rtc::rtc_result_t result;
+  bool started;
+  bool finished;
+} handoff_t;
+
+static RTC_HandleTypeDef hrtc;
+static rtc my_rtc
+  { &hrtc };
+
+static const sim_faults_t normal =
+  { SIM_FLAG_DELAY, SIM_FLAG_DELAY, SIM_FLAG_DELAY, false };
+
+/**
+ * @brief  Completion function, counts the calls.
+ * @param  result: result of the operation.
+ * @param  arg: pointer to the completions record.
+ */
+static void
+completed (rtc::rtc_result_t result, void* arg)
+{
+  completions_t* c = static_cast<completions_t*> (arg);
+
+  c->calls++;
+  c->result = result;
+  c->thread = sim_self ();
+}
+
+/**
+ * @brief  Start from a reset peripheral, powered and set to START_TIME.
+ * @param  seed: seed of the thread scheduling.
+ */
+static void
+setup (uint32_t seed = 1)
+{
+  time_t t = START_TIME;
+
+  sim_reset (seed);
+  sim_rtc_reset (0, 0);
+  memset (&hrtc, 0, sizeof(hrtc));
+  CHECK(my_rtc.power (true) == rtc::ok);
+  CHECK(my_rtc.set_time (&t) == rtc::ok);
+}
+
+/**
+ * @brief  Fill in an alarm on a given second of every minute.
+ */
+static void
+every_minute (struct tm* when, int second)
+{
+  when->tm_wday = rtc::alarm_ignored;
+  when->tm_mday = rtc::alarm_ignored;
+  when->tm_hour = rtc::alarm_ignored;
+  when->tm_min = rtc::alarm_ignored;
+  when->tm_sec = second;
+}
+
+/**
+ * @brief  Check that the driver released the peripheral.
+ */
+static void
+check_released (void)
+{
+  CHECK(hrtc.Lock == HAL_UNLOCKED);
+  CHECK(sim_rtc_idle ());
+  CHECK(sim_rtc_violations () == 0);
+}
+
+/**
+ * @brief  An operation completes when waited for, and writes the registers.
+ */
+static void
+test_completion (void)
+{
+  rtc::request req;
+  time_t t = START_TIME + 100, now;
+  uint64_t seq;
+  int64_t value;
+  struct tm when;
+
+  setup ();
+  seq = sim_rtc_seq ();
+
+  CHECK(req.done ());
+  CHECK(my_rtc.set_time_async (&t, &req) == rtc::ok);
+  CHECK(!req.done ());
+  CHECK(!sim_rtc_changed (SIM_CALENDAR, seq, &value));
+  CHECK(my_rtc.wait (&req) == rtc::ok);
+  CHECK(req.done ());
+  CHECK(req.result () == rtc::ok);
+  CHECK(sim_rtc_changed (SIM_CALENDAR, seq, &value) && value == t);
+  CHECK(my_rtc.get_time (&now) == rtc::ok && now == t);
+
+  seq = sim_rtc_seq ();
+  every_minute (&when, 15);
+  CHECK(my_rtc.set_alarm_async (rtc::alarm_b, &when, &req) == rtc::ok);
+  CHECK(my_rtc.wait (&req) == rtc::ok);
+  CHECK(sim_rtc_changed (SIM_ALARM_B, seq, &value)
+      && (value & 0x7F) == 0x15 && (value & RTC_ALRMAR_MSK1) == 0);
+
+  check_released ();
+}
+
+/**
+ * @brief  rtc::poll () advances the operation without waiting, and reports
+ *      whether it is still pending.
+ */
+static void
+test_poll (void)
+{
+  sim_faults_t slow = normal;
+  rtc::request req;
+  time_t t = START_TIME + 200;
+
+  setup ();
+  CHECK(!my_rtc.poll ());
+
+  slow.initf_delay = 5000;
+  sim_rtc_faults (&slow);
+  CHECK(my_rtc.set_time_async (&t, &req) == rtc::ok);
+  CHECK(my_rtc.poll ());
+  sim_sleep_until (sim_now () + 2000);
+  CHECK(my_rtc.poll ());
+  CHECK(!req.done ());
+
+  // INITF set: the registers are written, then RSF is waited for
+  sim_sleep_until (sim_now () + 5000);
+  CHECK(my_rtc.poll ());
+  sim_sleep_until (sim_now () + 1000);
+  CHECK(!my_rtc.poll ());
+  CHECK(req.done () && req.result () == rtc::ok);
+  CHECK(!my_rtc.poll ());
+
+  sim_rtc_faults (&normal);
+  check_released ();
+}
+
+/**
+ * @brief  The completion function is called once, with the result.
+ */
+static void
+test_callback (void)
+{
+  completions_t c =
+    { 0, rtc::busy, -1 };
+  rtc::request req
+    { completed, &c };
+  time_t t = START_TIME + 300;
+  struct tm when;
+
+  setup ();
+
+  CHECK(my_rtc.set_time_async (&t, &req) == rtc::ok);
+  CHECK(c.calls == 0);
+  CHECK(my_rtc.wait (&req) == rtc::ok);
+  CHECK(c.calls == 1 && c.result == rtc::ok);
+
+  every_minute (&when, 30);
+  CHECK(my_rtc.set_alarm_async (rtc::alarm_a, &when, &req) == rtc::ok);
+  CHECK(my_rtc.wait (&req) == rtc::ok);
+  CHECK(c.calls == 2 && c.result == rtc::ok);
+
+  check_released ();
+}
+
+/**
+ * @brief  While an operation is pending, the peripheral is busy for any other
+ *      operation, and a pending request cannot be reused.
+ */
+static void
+test_busy (void)
+{
+  sim_faults_t slow = normal;
+  rtc::request req, other;
+  time_t t = START_TIME + 400, now;
+  struct tm when;
+
+  setup ();
+  every_minute (&when, 45);
+
+  CHECK(my_rtc.set_alarm_async (0, &when, &other) == rtc::invalid_param);
+
+  slow.initf_delay = 5000;
+  sim_rtc_faults (&slow);
+  CHECK(my_rtc.set_time_async (&t, &req) == rtc::ok);
+
+  CHECK(my_rtc.set_time_async (&t, &other) == rtc::busy);
+  CHECK(my_rtc.set_alarm_async (rtc::alarm_a, &when, &other) == rtc::busy);
+  CHECK(my_rtc.set_time (&t) == rtc::busy);
+  CHECK(my_rtc.set_alarm (rtc::alarm_a, &when) == rtc::busy);
+  CHECK(my_rtc.set_wakeup (10) == rtc::busy);
+  CHECK(my_rtc.get_time (&now) == rtc::ok);
+  CHECK(other.done ());
+
+  CHECK(my_rtc.wait (&req) == rtc::ok);
+  sim_rtc_faults (&normal);
+
+  // the peripheral is free again
+  CHECK(my_rtc.set_alarm_async (rtc::alarm_a, &when, &req) == rtc::ok);
+  CHECK(my_rtc.set_time_async (&t, &req) == rtc::busy);
+  CHECK(my_rtc.wait (&req) == rtc::ok);
+  CHECK(my_rtc.set_time (&t) == rtc::ok);
+
+  check_released ();
+}
+
+/**
+ * @brief  When the peripheral does not respond, the operation fails with
+ *      rtc::timeout after 1 s, releasing the peripheral.
+ */
+static void
+test_timeout (void)
+{
+  sim_faults_t stuck = normal;
+  completions_t c =
+    { 0, rtc::ok, -1 };
+  rtc::request req
+    { completed, &c };
+  time_t t = START_TIME + 500;
+  uint64_t begin, seq;
+  int64_t value;
+  struct tm when;
+
+  setup ();
+  every_minute (&when, 5);
+
+  // INITF never set: the calendar is not written
+  stuck.initf_delay = SIM_STUCK;
+  sim_rtc_faults (&stuck);
+  seq = sim_rtc_seq ();
+  begin = sim_now ();
+  CHECK(my_rtc.set_time_async (&t, &req) == rtc::ok);
+  CHECK(my_rtc.wait (&req) == rtc::timeout);
+  CHECK(sim_now () - begin >= ASYNC_TIMEOUT_US - 1000);
+  CHECK(sim_now () - begin <= ASYNC_TIMEOUT_US + 2000);
+  CHECK(c.calls == 1 && c.result == rtc::timeout);
+  CHECK(!sim_rtc_changed (SIM_CALENDAR, seq, &value));
+  sim_rtc_faults (&normal);
+  check_released ();
+
+  // RSF never set: the calendar is written, but not synchronized
+  stuck = normal;
+  stuck.rsf_delay = SIM_STUCK;
+  sim_rtc_faults (&stuck);
+  seq = sim_rtc_seq ();
+  CHECK(my_rtc.set_time_async (&t, &req) == rtc::ok);
+  CHECK(my_rtc.wait (&req) == rtc::timeout);
+  CHECK(c.calls == 2 && c.result == rtc::timeout);
+  CHECK(sim_rtc_changed (SIM_CALENDAR, seq, &value) && value == t);
+  sim_rtc_faults (&normal);
+  check_released ();
+
+  // ALRAWF never set, after the alarm was enabled
+  CHECK(my_rtc.set_alarm (rtc::alarm_a, &when) == rtc::ok);
+  stuck = normal;
+  stuck.wf_delay = SIM_STUCK;
+  sim_rtc_faults (&stuck);
+  seq = sim_rtc_seq ();
+  begin = sim_now ();
+  CHECK(my_rtc.set_alarm_async (rtc::alarm_a, &when, &req) == rtc::ok);
+  CHECK(my_rtc.wait (&req) == rtc::timeout);
+  CHECK(sim_now () - begin >= ASYNC_TIMEOUT_US - 1000);
+  CHECK(sim_now () - begin <= ASYNC_TIMEOUT_US + 2000);
+  CHECK(c.calls == 3 && c.result == rtc::timeout);
+  CHECK(!sim_rtc_changed (SIM_ALARM_A, seq, &value));
+  sim_rtc_faults (&normal);
+  check_released ();
+
+  // the next operations succeed
+  CHECK(my_rtc.set_time_async (&t, &req) == rtc::ok);
+  CHECK(my_rtc.wait (&req) == rtc::ok);
+  CHECK(my_rtc.set_alarm_async (rtc::alarm_a, &when, &req) == rtc::ok);
+  CHECK(my_rtc.wait (&req) == rtc::ok);
+  CHECK(c.calls == 5 && c.result == rtc::ok);
+  check_released ();
+}
+
+/**
+ * @brief  Thread waiting for an operation. The request lives in a local
+ *      buffer, reused for a new request as soon as the wait returns, like
+ *      a stack frame would be.
+ */
+static void*
+waiter (void* arg)
+{
+  handoff_t* h = static_cast<handoff_t*> (arg);
+  alignas(rtc::request) unsigned char storage[sizeof(rtc::request)];
+  rtc::request* req;
+
+  req = new (storage) rtc::request (completed, &h->completions);
+  h->started = (my_rtc.set_time_async (&h->t, req) == rtc::ok);
+  if (h->started)
+    h->result = my_rtc.wait (req);
+  req->~request ();
+
+  req = new (storage) rtc::request (completed, &h->stale);
+  rtos::sysclock.sleep_for (2);
+  req->~request ();
+  h->finished = true;
+  return nullptr;
+}
+
+/**
+ * @brief  Thread polling the driver, e.g. a deferred poll on the interrupt.
+ *      It polls just before each system tick, so the waiter wakes up while
+ *      the poll is in its critical section and runs as soon as it ends.
+ */
+static void*
+poller (void* arg)
+{
+  handoff_t* h = static_cast<handoff_t*> (arg);
+
+  while (!h->finished)
+    {
+      sim_sleep_until ((sim_now () + 1) / 1000 * 1000 + 999);
+      my_rtc.poll ();
+    }
+  return nullptr;
+}
+
+/**
+ * @brief  An operation completed by another thread while waited for: the
+ *      completion function is called once, never through a request already
+ *      reused, and the waiter does not keep the poller (of lower priority)
+ *      from running.
+ */
+static void
+test_handoff (void)
+{
+  sim_faults_t slow = normal;
+  handoff_t h;
+  int by_poller = 0;
+
+  for (uint32_t round = 1; round <= 200; round++)
+    {
+      setup (round);
+      memset (&h, 0, sizeof(h));
+      h.t = START_TIME + round;
+      h.completions.result = h.stale.result = rtc::busy;
+      slow.initf_delay = 100 + round * 37 % 3000;
+      sim_rtc_faults (&slow);
+
+      // the waiter has the higher priority
+      sim_spawn (waiter, &h, 1);
+      sim_spawn (poller, &h, 0);
+      sim_run ();
+
+      CHECK(h.started && h.result == rtc::ok);
+      CHECK(h.completions.calls == 1 && h.completions.result == rtc::ok);
+      CHECK(h.stale.calls == 0);
+      if (h.completions.thread == 1)
+        by_poller++;
+      sim_rtc_faults (&normal);
+      check_released ();
+    }
+
+  // the poller, polling first, completes most of them
+  CHECK(by_poller > 100);
+}
+
+int
+main (void)
+{
+  static const struct
+  {
+    const char* name;
+    void
+    (*func) (void);
+  } tests[] =
+    {
+      { "completion", test_completion },
+      { "poll", test_poll },
+      { "callback", test_callback },
+      { "busy while pending", test_busy },
+      { "timeout", test_timeout },
+      { "hand-off", test_handoff } };
+  int before;
+
+  // the driver converts the calendar with the local time functions
+  setenv ("TZ", "UTC", 1);
+  tzset ();
+
+  for (unsigned i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+      before = failures;
+      tests[i].func ();
+      printf ("%-20s %s\n", tests[i].name,
+              failures == before ? "ok" : "FAILED");
+    }
+
+  printf ("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+  return failures ? 1 : 0;
+}
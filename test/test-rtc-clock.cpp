@@ -0,0 +1,318 @@
+/*
+ * test-rtc-clock.cpp
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Host test of the generic rtc_clock interface, using the simulated backend;
+ * some checks also run on the driver, against the simulated peripheral.
+ * Like the other tests, it runs on a host (Linux, macOS):
+ *
+ *   g++ -std=c++11 -O2 -Wall -pthread -I../src -Ihost test-rtc-clock.cpp \
+ *       host/host-rtc.cpp host/host-rtos.cpp ../src/rtc-drv.cpp \
+ *       -o test-rtc-clock
+ *   ./test-rtc-clock
+ *
+ * The program exits with a non-zero status if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "cmsis_device.h"
+#include <cmsis-plus/rtos/os.h>
+#include "rtc-clock.h"
+#include "rtc-drv.h"
+#include "rtc-sim.h"
+#include "host-sim.h"
+#include "host-test.h"
+
+#define BENCH_LOOPS 10000000
+
+/**
+ * @brief  Example of generic code: program an alarm at a given second of
+ *      every minute, on any backend.
+ * @param  clk: the clock.
+ * @param  which: which alarm.
+ * @param  second: second of the minute.
+ * @return ok if successful, or an RTC error.
+ */
+template<typename T>
+  rtc_clock_base::rtc_result_t
+  every_minute (rtc_clock<T>& clk, int which, int second)
+  {
+    struct tm when;
+
+    when.tm_wday = rtc_clock_base::alarm_ignored;
+    when.tm_mday = rtc_clock_base::alarm_ignored;
+    when.tm_hour = rtc_clock_base::alarm_ignored;
+    when.tm_min = rtc_clock_base::alarm_ignored;
+    when.tm_sec = second;
+
+    return clk.set_alarm (which, &when);
+  }
+
+/**
+ * @brief  Example of generic code: keep a counter in a backup register.
+ * @param  clk: the clock.
+ * @param  reg_nr: the backup register.
+ * @return The new counter value.
+ */
+template<typename T>
+  uint32_t
+  count_boot (rtc_clock<T>& clk, uint8_t reg_nr)
+  {
+    uint32_t value = clk.get_bk_register (reg_nr) + 1;
+
+    clk.set_bk_register (reg_nr, value);
+    return value;
+  }
+
+/**
+ * @brief  Generic check: the alarms read back as they were set, on any
+ *      backend.
+ * @param  clk: the clock.
+ */
+template<typename T>
+  void
+  check_alarms_read_back (rtc_clock<T>& clk)
+  {
+    static constexpr int x = rtc_clock_base::alarm_ignored;
+    static const int alarms[][5] =
+      {
+        // wday, mday, hour, min, sec
+          { x, x, x, x, 30 },
+          { x, x, x, 15, 0 },
+          { x, x, 23, 59, 59 },
+          { 0, x, 6, 30, 0 },   // Sunday
+          { 3, x, x, 0, 0 },    // Wednesday
+          { x, 14, 2, 40, 0 },
+          { 5, 31, 12, x, x } }; // the day of the month wins
+    struct tm when, back;
+
+    for (unsigned i = 0; i < sizeof(alarms) / sizeof(alarms[0]); i++)
+      {
+        memset (&when, 0, sizeof(when));
+        when.tm_wday = alarms[i][0];
+        when.tm_mday = alarms[i][1];
+        when.tm_hour = alarms[i][2];
+        when.tm_min = alarms[i][3];
+        when.tm_sec = alarms[i][4];
+        CHECK(clk.set_alarm (T::alarm_b, &when) == rtc_clock_base::ok);
+
+        memset (&back, 0x55, sizeof(back));
+        CHECK(clk.get_alarm (T::alarm_b, &back) == rtc_clock_base::ok);
+        CHECK(back.tm_wday == (when.tm_mday > 0 ? x : when.tm_wday));
+        CHECK(back.tm_mday == when.tm_mday);
+        CHECK(back.tm_hour == when.tm_hour);
+        CHECK(back.tm_min == when.tm_min);
+        CHECK(back.tm_sec == when.tm_sec);
+      }
+  }
+
+/**
+ * @brief  Return the time of a monotonic host clock, in nanoseconds.
+ */
+static uint64_t
+host_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief  Read the time in a loop, through the interface.
+ */
+template<typename T>
+  __attribute__ ((noinline)) time_t
+  bench_generic (rtc_clock<T>& clk, int loops)
+  {
+    time_t t, sum = 0;
+
+    for (int i = 0; i < loops; i++)
+      {
+        clk.get_time (&t);
+        sum += t + clk.get_bk_register (i & 31);
+      }
+    return sum;
+  }
+
+/**
+ * @brief  Read the time in a loop, calling the backend directly.
+ */
+__attribute__ ((noinline)) static time_t
+bench_direct (rtc_sim& clk, int loops)
+{
+  time_t t, sum = 0;
+
+  for (int i = 0; i < loops; i++)
+    {
+      clk.get_time (&t);
+      sum += t + clk.get_bk_register (i & 31);
+    }
+  return sum;
+}
+
+static void
+test_time (rtc_sim& sim)
+{
+  rtc_clock<rtc_sim>& clk = sim;
+  time_t t = 1500000000, now;
+
+  CHECK(clk.set_time (&t) == rtc_sim::ok);
+  CHECK(clk.get_time (&now) == rtc_sim::ok && now == t);
+
+  sim.advance (999999);
+  clk.get_time (&now);
+  CHECK(now == t);
+  sim.advance (1);
+  clk.get_time (&now);
+  CHECK(now == t + 1);
+}
+
+static void
+test_calibration (rtc_sim& sim)
+{
+  rtc_clock<rtc_sim>& clk = sim;
+  time_t t = 1500000000, now;
+
+  CHECK(clk.set_cal_factor (513) == rtc_sim::invalid_param);
+  CHECK(clk.set_cal_factor (-512) == rtc_sim::invalid_param);
+  CHECK(clk.set_cal_factor (-100) == rtc_sim::ok);
+  CHECK(clk.get_cal_factor () == -100);
+
+  // a +95.37 ppm oscillator is compensated by -100 steps
+  sim.set_drift (100 * rtc_sim::CAL_STEP_PPM);
+  clk.set_time (&t);
+  for (int i = 0; i < 86400; i++)
+    sim.advance (1000000);
+  clk.get_time (&now);
+  CHECK(now == t + 86400 || now == t + 86399);
+
+  sim.set_drift (0);
+  clk.set_cal_factor (0);
+}
+
+static void
+test_alarms (rtc_sim& sim)
+{
+  rtc_clock<rtc_sim>& clk = sim;
+  time_t t = 1500000000;        // 2017-07-14 02:40:00 UTC
+  struct tm when;
+
+  clk.set_time (&t);
+  CHECK(every_minute (clk, rtc_sim::alarm_a, 30) == rtc_sim::ok);
+  CHECK(clk.get_alarm (rtc_sim::alarm_a, &when) == rtc_sim::ok);
+  CHECK(when.tm_sec == 30 && when.tm_min == rtc_sim::alarm_ignored);
+  CHECK(clk.set_alarm (5, &when) == rtc_sim::invalid_param);
+
+  for (int i = 0; i < 180; i++)
+    sim.advance (1000000);
+  CHECK(sim.alarm_count (rtc_sim::alarm_a) == 3);
+  CHECK(sim.alarm_count (rtc_sim::alarm_b) == 0);
+
+  CHECK(clk.reset_alarm (rtc_sim::alarm_a) == rtc_sim::ok);
+  for (int i = 0; i < 60; i++)
+    sim.advance (1000000);
+  CHECK(sim.alarm_count (rtc_sim::alarm_a) == 3);
+
+  CHECK(clk.set_wakeup (0) == rtc_sim::invalid_param);
+  CHECK(clk.set_wakeup (10) == rtc_sim::ok);
+  for (int i = 0; i < 35; i++)
+    sim.advance (1000000);
+  CHECK(sim.wakeup_count () == 3);
+}
+
+static void
+test_alarms_read_back (rtc_sim& sim)
+{
+  RTC_HandleTypeDef hrtc;
+  rtc drv
+    { &hrtc };
+
+  // the same generic code gives the same results on both backends
+  check_alarms_read_back (sim);
+
+  sim_reset (1);
+  sim_rtc_reset (0, 0);
+  memset (&hrtc, 0, sizeof(hrtc));
+  CHECK(drv.power (true) == rtc::ok);
+  check_alarms_read_back (drv);
+  CHECK(sim_rtc_violations () == 0);
+}
+
+static void
+test_backup (rtc_sim& sim)
+{
+  rtc_clock<rtc_sim>& clk = sim;
+
+  CHECK(count_boot (clk, 3) == 1);
+  CHECK(count_boot (clk, 3) == 2);
+  clk.set_bk_register (31, 0xDEADBEEF);
+  CHECK(clk.get_bk_register (31) == 0xDEADBEEF);
+  clk.set_bk_register (32, 1);  // out of range, ignored
+  CHECK(clk.get_bk_register (32) == 0);
+}
+
+static void
+bench (rtc_sim& sim)
+{
+  uint64_t begin, direct, generic;
+  volatile time_t sink;
+
+  begin = host_ns ();
+  sink = bench_direct (sim, BENCH_LOOPS);
+  direct = host_ns () - begin;
+
+  begin = host_ns ();
+  sink = bench_generic (sim, BENCH_LOOPS);
+  generic = host_ns () - begin;
+  (void) sink;
+
+  printf ("direct calls:    %.2f ns/loop\n", (double) direct / BENCH_LOOPS);
+  printf ("interface calls: %.2f ns/loop\n", (double) generic / BENCH_LOOPS);
+}
+
+int
+main (void)
+{
+  rtc_sim sim;
+
+  test_time (sim);
+  test_calibration (sim);
+  test_alarms (sim);
+  test_alarms_read_back (sim);
+  test_backup (sim);
+  bench (sim);
+
+  printf ("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * test-rtc-shift.cpp
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Test of shift_time () with the prescaler in use, either set by power ()
+ * or kept from an earlier initialization (the RTC is then not initialized
+ * again). It runs on a host (Linux, macOS), the driver being built against
+ * the simulated peripheral in the host folder:
+ *
+ *   g++ -std=c++11 -O2 -Wall -pthread -I../src -Ihost test-rtc-shift.cpp \
+ *       host/host-rtc.cpp host/host-rtos.cpp ../src/rtc-drv.cpp \
+ *       -o test-rtc-shift
+ *   ./test-rtc-shift
+ *
+ * The program exits with a non-zero status if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cmsis_device.h"
+#include <cmsis-plus/rtos/os.h>
+#include "rtc-drv.h"
+#include "host-sim.h"
+#include "host-test.h"
+
+#define START_TIME 1700000000   // 2023-11-14 22:13:20 UTC
+
+static RTC_HandleTypeDef hrtc;
+static rtc my_rtc
+  { &hrtc };
+
+// shifts tried, us
+static const int32_t shifts[] =
+  { 1000, -1000, 250000, -250000, 500000, -500000, 999999, -999999, 1, -1 };
+
+/**
+ * @brief  Shift the clock by the given amounts and check the result
+ *      against the peripheral.
+ * @param  prediv_s: synchronous prescaler in use.
+ */
+static void
+check_shifts (uint32_t prediv_s)
+{
+  int64_t step = 1000000 / (prediv_s + 1) + 1;
+  uint64_t seq, at;
+  int64_t before, moved, value, shift;
+  rtc::rtc_result_t result;
+  int refused = 0;
+
+  for (unsigned i = 0; i < sizeof(shifts) / sizeof(shifts[0]); i++)
+    {
+      // with a prescaler above 0x3FFF a shift may leave SS[15] set, the
+      // driver refuses the next one until it clears
+      for (;;)
+        {
+          seq = sim_rtc_seq ();
+          at = sim_now ();
+          before = sim_rtc_time_us ();
+          result = my_rtc.shift_time (shifts[i]);
+          if (result != rtc::busy)
+            break;
+          CHECK(!sim_rtc_changed (SIM_SHIFT, seq, &value));
+          refused++;
+          sim_sleep_until (sim_now () + 100000);
+        }
+      CHECK(result == rtc::ok);
+
+      // the shift written: as much as asked, at the resolution of the
+      // prescaler (a delay of a whole second is one step short)
+      if (sim_rtc_changed (SIM_SHIFT, seq, &value))
+        {
+          CHECK(((uint32_t) value & 0x7FFF) <= prediv_s);
+          shift = ((value & RTC_SHIFTADD1S_SET) ? 1000000 : 0)
+              - (value & 0x7FFF) * 1000000 / (prediv_s + 1);
+          CHECK(shift - shifts[i] <= step && shifts[i] - shift <= step);
+        }
+      else
+        {
+          // less than half the resolution, nothing to do
+          CHECK(shifts[i] * 2 < step && -shifts[i] * 2 < step);
+        }
+
+      // and the clock moved as much, give or take the resolution of the
+      // two readings
+      moved = sim_rtc_time_us () - before - (int64_t) (sim_now () - at);
+      CHECK(moved - shifts[i] <= 2 * step && shifts[i] - moved <= 2 * step);
+    }
+  CHECK((refused != 0) == (prediv_s > 0x3FFF));
+  CHECK(sim_rtc_violations () == 0);
+  CHECK(hrtc.Lock == HAL_UNLOCKED);
+  CHECK(sim_rtc_idle ());
+}
+
+/**
+ * @brief  The RTC was already initialized, power () keeps its prescaler.
+ * @param  prediv_s: the prescaler.
+ */
+static void
+test_kept (uint32_t prediv_s)
+{
+  sim_reset (1);
+  sim_rtc_reset (prediv_s, START_TIME);
+  memset (&hrtc, 0, sizeof(hrtc));
+  CHECK(my_rtc.power (true) == rtc::ok);
+  CHECK((RTC->PRER & RTC_PRER_PREDIV_S) == prediv_s);
+  check_shifts (prediv_s);
+}
+
+/**
+ * @brief  Backup domain reset, power () sets its own prescaler.
+ */
+static void
+test_initialized (void)
+{
+  time_t t = START_TIME;
+
+  sim_reset (1);
+  sim_rtc_reset (0, 0);
+  memset (&hrtc, 0, sizeof(hrtc));
+  CHECK(my_rtc.power (true) == rtc::ok);
+  CHECK(my_rtc.set_time (&t) == rtc::ok);
+  check_shifts (RTC->PRER & RTC_PRER_PREDIV_S);
+}
+
+int
+main (void)
+{
+  test_kept (255);
+  test_kept (0x7FFF);
+  test_initialized ();
+
+  printf ("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,648 @@
+/*
+ * test-rtc-stress.cpp
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Contention and fault injection test of the driver. It runs on a host
+ * (Linux, macOS), the driver being built against the simulated peripheral
+ * and scheduler in the host folder:
+ *
+ *   g++ -std=c++11 -O2 -Wall -pthread -I../src -Ihost test-rtc-stress.cpp \
+ *       host/host-rtc.cpp host/host-rtos.cpp ../src/rtc-drv.cpp \
+ *       -o test-rtc-stress
+ *   ./test-rtc-stress [seed]
+ *
+ * Several threads call the driver (time, alarms, wake-up timer and backup
+ * registers, synchronously and asynchronously) in a random mix, while another thread injects faults in the
+ * peripheral: slow or stuck INITF, ALRxWF/WUTWF and RSF flags, HAL_ERROR
+ * returns and a locked HAL handle. The operations, the faults and the
+ * thread scheduling are all drawn from the seed, in simulated time, so a
+ * run is exactly repeatable; the test runs twice to check it. The results
+ * are checked against what the peripheral really did, and no hardware is
+ * touched.
+ *
+ * The program exits with a non-zero status if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cmsis_device.h"
+#include <cmsis-plus/rtos/os.h>
+#include "rtc-drv.h"
+#include "host-sim.h"
+#include "host-test.h"
+
+#define STRESS_WORKERS 4
+#define STRESS_DURATION_MS 60000        // simulated time
+#define STRESS_START_TIME 1700000000    // 2023-11-14 22:13:20 UTC
+#define STRESS_BK_FIRST 16      // first backup register used by the workers
+#define STRESS_BK_SHARED 4      // number of backup registers, all shared
+#define STRESS_SHOWN_ERRORS 10
+
+using namespace os;
+
+enum
+{
+  op_get_time, op_set_time, op_set_alarm, op_set_wakeup, op_bk_register,
+  op_set_time_async, op_set_alarm_async, op_count
+};
+
+static const char* op_names[op_count] =
+  { "get_time", "set_time", "set_alarm", "set_wakeup", "bk_register",
+      "time_async", "alarm_async" };
+
+enum
+{
+  fault_slow_initf, fault_slow_wf, fault_slow_rsf, fault_hal_error,
+  fault_hal_lock, fault_stuck_initf, fault_stuck_wf, fault_stuck_rsf,
+  fault_count
+};
+
+// each kind of slow fault is injected so many times per stuck fault
+static constexpr int MILD_REPEAT = 30;
+static constexpr int CYCLE = fault_stuck_initf * MILD_REPEAT
+    + (fault_count - fault_stuck_initf);
+
+static const char* fault_names[fault_count] =
+  { "slow INITF", "slow WF", "slow RSF", "HAL error", "HAL lock",
+      "stuck INITF", "stuck WF", "stuck RSF" };
+
+// latency histogram, bucket n holds values from 2^n to 2^(n+1) - 1 us
+static constexpr int LAT_BUCKETS = 32;
+
+typedef struct
+{
+  uint32_t calls;
+  uint32_t ok;
+  uint32_t busy;
+  uint32_t error;
+  uint32_t timeout;
+  uint32_t invalid_param;
+  uint32_t max_latency;
+  uint32_t latency[LAT_BUCKETS];
+} op_stats_t;
+
+typedef struct
+{
+  int index;
+  uint32_t seed;
+  uint32_t lost;                // ok returned, but nothing written
+  uint32_t time_errors;         // time read outside of the real interval
+  uint32_t partial;             // error returned, but the calendar changed
+  uint32_t contended;           // backup register overwritten by another
+  op_stats_t stats[op_count];
+} worker_t;
+
+static RTC_HandleTypeDef hrtc;
+static rtc my_rtc
+  { &hrtc };
+
+static uint64_t end_us;
+static uint32_t injected[fault_count];
+static uint32_t shown;
+/**
+ * @brief  Account for one driver call.
+ * @param  st: statistics of the operation.
+ * @param  result: result returned by the driver.
+ * @param  us: duration of the call in microseconds.
+ */
+static void
+record (op_stats_t& st, rtc::rtc_result_t result, uint32_t us)
+{
+  st.calls++;
+  switch (result)
+    {
+    case rtc::ok:
+      st.ok++;
+      break;
+    case rtc::busy:
+      st.busy++;
+      break;
+    case rtc::timeout:
+      st.timeout++;
+      break;
+    case rtc::invalid_param:
+      st.invalid_param++;
+      break;
+    default:
+      st.error++;
+      break;
+    }
+  st.latency[us ? 31 - __builtin_clz (us) : 0]++;
+  if (us > st.max_latency)
+    st.max_latency = us;
+}
+
+/**
+ * @brief  Return the upper bound of a latency percentile.
+ * @param  st: statistics of the operation.
+ * @param  pct: percentile (1 to 100).
+ * @return Latency in microseconds.
+ */
+static uint32_t
+percentile (const op_stats_t& st, uint32_t pct)
+{
+  uint32_t target = (st.calls * pct + 99) / 100;
+  uint32_t sum = 0;
+
+  for (int i = 0; target && i < LAT_BUCKETS; i++)
+    {
+      sum += st.latency[i];
+      if (sum >= target)
+        return (2u << i) - 1;
+    }
+  return 0;
+}
+
+/**
+ * @brief  Report an update that did not take effect although the driver
+ *      returned rtc::ok.
+ * @param  w: the worker.
+ * @param  op: the operation.
+ */
+static void
+lost (worker_t* w, int op)
+{
+  w->lost++;
+  if (shown++ < STRESS_SHOWN_ERRORS)
+    printf ("worker %d: %s returned ok, but did not take effect (%llu us)\n",
+            w->index, op_names[op], (unsigned long long) sim_now ());
+}
+
+/**
+ * @brief  Check a time value read from the RTC: it must be the time of the
+ *      calendar at some moment during the call.
+ * @param  w: the worker that read the time.
+ * @param  before: calendar time at the beginning of the call, us.
+ * @param  after: calendar time at the end of the call, us.
+ * @param  t: the time read.
+ * @param  usec: its fraction of second.
+ */
+static void
+check_time (worker_t* w, int64_t before, int64_t after, time_t t,
+            uint32_t usec)
+{
+  int64_t value = (int64_t) t * 1000000 + usec;
+
+  if (value < before || value > after)
+    {
+      w->time_errors++;
+      if (shown++ < STRESS_SHOWN_ERRORS)
+        printf ("worker %d: time %lld us out of [%lld, %lld]\n", w->index,
+                (long long) value, (long long) before, (long long) after);
+    }
+}
+
+/**
+ * @brief  Check the calendar write of a (possibly asynchronous) set_time.
+ * @param  w: the worker.
+ * @param  op: the operation.
+ * @param  result: result returned by the driver.
+ * @param  seq: changes of the peripheral before the call.
+ * @param  t: the time set.
+ */
+static void
+check_set_time (worker_t* w, int op, rtc::rtc_result_t result, uint64_t seq,
+                time_t t)
+{
+  int64_t value;
+
+  if (sim_rtc_changed (SIM_CALENDAR, seq, &value))
+    {
+      if (result != rtc::ok)
+        w->partial++;
+      else if (value < t || value > t + 2)
+        lost (w, op);
+    }
+  else if (result == rtc::ok)
+    lost (w, op);
+}
+
+/**
+ * @brief  Check the alarm register write of a (possibly asynchronous)
+ *      set_alarm, for an alarm on a given second of every minute.
+ * @param  w: the worker.
+ * @param  op: the operation.
+ * @param  result: result returned by the driver.
+ * @param  seq: changes of the peripheral before the call.
+ * @param  which: which alarm.
+ * @param  second: the second of the alarm.
+ */
+static void
+check_set_alarm (worker_t* w, int op, rtc::rtc_result_t result, uint64_t seq,
+                 int which, int second)
+{
+  const uint32_t masks = RTC_ALRMAR_MSK4 | RTC_ALRMAR_MSK3 | RTC_ALRMAR_MSK2;
+  int64_t value;
+
+  if (result == rtc::ok
+      && (!sim_rtc_changed (which == rtc::alarm_a ? SIM_ALARM_A : SIM_ALARM_B,
+                            seq, &value)
+          || ((uint32_t) value & (masks | RTC_ALRMAR_MSK1 | 0x7F))
+              != (masks | RTC_ByteToBcd2 (second))))
+    lost (w, op);
+}
+
+/**
+ * @brief  Worker thread: call the driver in a random mix until the end of
+ *      the test, and check each result against the peripheral.
+ * @param  args: pointer to the worker's context.
+ */
+static void*
+worker (void* args)
+{
+  worker_t* w = static_cast<worker_t*> (args);
+  uint32_t state = w->seed;
+  rtc::rtc_result_t result = rtc::ok;
+  rtc::request req;
+  uint64_t begin, seq;
+  int64_t before, after, value;
+  uint32_t r, usec, data, counter = 0;
+  uint16_t seconds;
+  struct tm when;
+  time_t t;
+  int op, which;
+  uint8_t reg;
+
+  while (sim_now () < end_us)
+    {
+      // think time, up to two ticks
+      rtos::sysclock.sleep_for (next_random (state) % 3);
+
+      r = next_random (state) % 100;
+      op = r < 35 ? op_get_time : r < 45 ? op_set_time :
+           r < 57 ? op_set_alarm : r < 67 ? op_set_wakeup :
+           r < 87 ? op_bk_register : r < 93 ? op_set_time_async :
+           op_set_alarm_async;
+      seq = sim_rtc_seq ();
+      begin = sim_now ();
+
+      switch (op)
+        {
+        case op_get_time:
+          seq = sim_rtc_time_seq ();
+          before = sim_rtc_time_us ();
+          result = my_rtc.get_time (&t, &usec);
+          after = sim_rtc_time_us ();
+          if (result == rtc::ok && sim_rtc_time_seq () == seq)
+            check_time (w, before, after, t, usec);
+          break;
+
+        case op_set_time:
+        case op_set_time_async:
+          // around the current time, so that the other checks hold
+          t = (time_t) (sim_rtc_time_us () / 1000000)
+              + (int) (next_random (state) % 3) - 1;
+          if (op == op_set_time)
+            result = my_rtc.set_time (&t);
+          else
+            {
+              result = my_rtc.set_time_async (&t, &req);
+              if (result == rtc::ok)
+                result = my_rtc.wait (&req);
+            }
+          check_set_time (w, op, result, seq, t);
+          break;
+
+        case op_set_alarm:
+        case op_set_alarm_async:
+          which = (next_random (state) & 1) ? rtc::alarm_a : rtc::alarm_b;
+          when.tm_wday = rtc::alarm_ignored;
+          when.tm_mday = rtc::alarm_ignored;
+          when.tm_hour = rtc::alarm_ignored;
+          when.tm_min = rtc::alarm_ignored;
+          when.tm_sec = next_random (state) % 60;
+          if (op == op_set_alarm)
+            result = my_rtc.set_alarm (which, &when);
+          else
+            {
+              result = my_rtc.set_alarm_async (which, &when, &req);
+              if (result == rtc::ok)
+                result = my_rtc.wait (&req);
+            }
+          check_set_alarm (w, op, result, seq, which, when.tm_sec);
+          break;
+
+        case op_set_wakeup:
+          seconds = 1 + next_random (state) % 60;
+          result = my_rtc.set_wakeup (seconds);
+          if (result == rtc::ok
+              && (!sim_rtc_changed (SIM_WAKEUP, seq, &value)
+                  || value != seconds - 1))
+            lost (w, op);
+          break;
+
+        case op_bk_register:
+          // the registers are shared, a value read back may be overwritten
+          // only if another thread wrote the register meanwhile
+          reg = STRESS_BK_FIRST + next_random (state) % STRESS_BK_SHARED;
+          data = ((uint32_t) w->index << 24) | (++counter & 0xFFFFFF);
+          my_rtc.set_bk_register (reg, data);
+          value = my_rtc.get_bk_register (reg);
+          result = rtc::ok;
+          if (sim_rtc_bkp_writer (reg) != sim_self ())
+            w->contended++;
+          else if ((uint32_t) value != data)
+            lost (w, op);
+          break;
+        }
+      record (w->stats[op], result, (uint32_t) (sim_now () - begin));
+    }
+  return nullptr;
+}
+
+/**
+ * @brief  Fault injector thread: inject each kind of fault a fixed number of
+ *      times per cycle, in random order, for a random duration. The stuck
+ *      flags last longer than two HAL timeouts (1 s each, set_wakeup () makes
+ *      two calls that wait), the other faults only slow down the driver and
+ *      are more frequent.
+ * @param  args: pointer to the seed.
+ */
+static void*
+injector (void* args)
+{
+  uint32_t state = *static_cast<uint32_t*> (args);
+  const sim_faults_t normal =
+    { SIM_FLAG_DELAY, SIM_FLAG_DELAY, SIM_FLAG_DELAY, false };
+  sim_faults_t faults;
+  int modes[CYCLE];
+  int next = CYCLE, mode, tmp, j;
+  uint32_t duration, delay;
+  bool locked;
+
+  while (sim_now () < end_us)
+    {
+      rtos::sysclock.sleep_for (20 + next_random (state) % 180);
+
+      if (next == CYCLE)
+        {
+          for (int i = 0; i < CYCLE; i++)
+            modes[i] = (i < fault_stuck_initf * MILD_REPEAT) ?
+                i % fault_stuck_initf :
+                i - fault_stuck_initf * (MILD_REPEAT - 1);
+          for (int i = CYCLE - 1; i > 0; i--)
+            {
+              j = next_random (state) % (i + 1);
+              tmp = modes[i];
+              modes[i] = modes[j];
+              modes[j] = tmp;
+            }
+          next = 0;
+        }
+      mode = modes[next++];
+      injected[mode]++;
+
+      faults = normal;
+      duration = 1 + next_random (state) % 20;
+      delay = 100 + next_random (state) % 5000;
+      switch (mode)
+        {
+        case fault_slow_initf:
+          faults.initf_delay = delay;
+          break;
+        case fault_slow_wf:
+          faults.wf_delay = delay;
+          break;
+        case fault_slow_rsf:
+          faults.rsf_delay = delay;
+          break;
+        case fault_hal_error:
+          faults.hal_error = true;
+          break;
+        case fault_stuck_initf:
+          faults.initf_delay = SIM_STUCK;
+          duration = 2100 + next_random (state) % 500;
+          break;
+        case fault_stuck_wf:
+          faults.wf_delay = SIM_STUCK;
+          duration = 2100 + next_random (state) % 500;
+          break;
+        case fault_stuck_rsf:
+          faults.rsf_delay = SIM_STUCK;
+          duration = 2100 + next_random (state) % 500;
+          break;
+        }
+
+      if (mode == fault_hal_lock)
+        {
+          // like another user of the HAL handle
+            {
+              rtos::interrupts::critical_section ics;
+              locked = (hrtc.Lock == HAL_UNLOCKED);
+              if (locked)
+                hrtc.Lock = HAL_LOCKED;
+            }
+          rtos::sysclock.sleep_for (duration);
+          if (locked)
+            hrtc.Lock = HAL_UNLOCKED;
+        }
+      else
+        {
+          sim_rtc_faults (&faults);
+          rtos::sysclock.sleep_for (duration);
+          sim_rtc_faults (&normal);
+        }
+    }
+  return nullptr;
+}
+
+/**
+ * @brief  Return the FNV-1a hash of a memory block, chained.
+ */
+static uint64_t
+hash (uint64_t h, const void* data, size_t size)
+{
+  const uint8_t* p = static_cast<const uint8_t*> (data);
+
+  while (size--)
+    {
+      h ^= *p++;
+      h *= 0x100000001B3ULL;
+    }
+  return h;
+}
+
+/**
+ * @brief  Run the stress test on a freshly reset peripheral.
+ * @param  seed: seed of the pseudo-random sequences and of the scheduling.
+ * @param  report: print the report.
+ * @return A digest of the results, equal for equal seeds.
+ */
+static uint64_t
+run (uint32_t seed, bool report)
+{
+  static worker_t workers[STRESS_WORKERS];
+  uint32_t injector_seed, elapsed_ms, lost = 0, time_errors = 0;
+  uint32_t partial = 0, contended = 0;
+  uint64_t start_us, digest = 0xCBF29CE484222325ULL;
+  time_t t = STRESS_START_TIME;
+  op_stats_t total, all;
+
+  sim_reset (seed);
+  sim_rtc_reset (0, 0);
+  memset (&hrtc, 0, sizeof(hrtc));
+  memset (injected, 0, sizeof(injected));
+  shown = 0;
+
+  CHECK(my_rtc.power (true) == rtc::ok);
+  CHECK(my_rtc.set_time (&t) == rtc::ok);
+
+  start_us = sim_now ();
+  end_us = start_us + STRESS_DURATION_MS * 1000ULL;
+
+  for (int i = 0; i < STRESS_WORKERS; i++)
+    {
+      memset (&workers[i], 0, sizeof(worker_t));
+      workers[i].index = i;
+      workers[i].seed = (seed + i) * 2654435761u;
+      if (workers[i].seed == 0)
+        workers[i].seed = 1;
+      sim_spawn (worker, &workers[i]);
+    }
+  injector_seed = seed ^ 0x5A5A5A5A;
+  if (injector_seed == 0)
+    injector_seed = 1;
+  sim_spawn (injector, &injector_seed);
+
+  sim_run ();
+
+  elapsed_ms = (uint32_t) ((sim_now () - start_us) / 1000);
+
+  // report, per operation
+  if (report)
+    {
+      printf ("seed %u, %d workers, %u ms (simulated), %u thread switches\n",
+              (unsigned) seed, STRESS_WORKERS, (unsigned) elapsed_ms,
+              (unsigned) sim_switches ());
+      printf ("%-12s %8s %8s %6s %6s %6s %6s %8s %8s %8s\n", "op", "calls",
+              "ops/s", "busy", "error", "tmout", "inval", "p50 us", "p99 us",
+              "max us");
+    }
+  memset (&all, 0, sizeof(op_stats_t));
+  for (int op = 0; op < op_count; op++)
+    {
+      memset (&total, 0, sizeof(op_stats_t));
+      for (int i = 0; i < STRESS_WORKERS; i++)
+        {
+          op_stats_t& st = workers[i].stats[op];
+          total.calls += st.calls;
+          total.ok += st.ok;
+          total.busy += st.busy;
+          total.error += st.error;
+          total.timeout += st.timeout;
+          total.invalid_param += st.invalid_param;
+          if (st.max_latency > total.max_latency)
+            total.max_latency = st.max_latency;
+          for (int b = 0; b < LAT_BUCKETS; b++)
+            total.latency[b] += st.latency[b];
+        }
+      all.busy += total.busy;
+      all.error += total.error;
+      all.timeout += total.timeout;
+      all.invalid_param += total.invalid_param;
+      if (report)
+        printf ("%-12s %8u %8u %6u %6u %6u %6u %8u %8u %8u\n", op_names[op],
+                (unsigned) total.calls,
+                (unsigned) (
+                    elapsed_ms ?
+                        (uint64_t) total.calls * 1000 / elapsed_ms : 0),
+                (unsigned) total.busy, (unsigned) total.error,
+                (unsigned) total.timeout, (unsigned) total.invalid_param,
+                (unsigned) percentile (total, 50),
+                (unsigned) percentile (total, 99),
+                (unsigned) total.max_latency);
+    }
+
+  for (int i = 0; i < STRESS_WORKERS; i++)
+    {
+      lost += workers[i].lost;
+      time_errors += workers[i].time_errors;
+      partial += workers[i].partial;
+      contended += workers[i].contended;
+    }
+
+  if (report)
+    {
+      printf ("faults injected:");
+      for (int i = 0; i < fault_count; i++)
+        printf ("%s %u %s", i ? "," : "", (unsigned) injected[i],
+                fault_names[i]);
+      printf ("\n");
+      printf ("lost updates: %u, time errors: %u, partial set_time: %u, "
+              "contended backup registers: %u, peripheral violations: %u\n",
+              (unsigned) lost, (unsigned) time_errors, (unsigned) partial,
+              (unsigned) contended, (unsigned) sim_rtc_violations ());
+    }
+
+  CHECK(lost == 0);
+  CHECK(time_errors == 0);
+  CHECK(sim_rtc_violations () == 0);
+  CHECK(sim_rtc_hal_errors () > 0);
+  CHECK(hrtc.Lock == HAL_UNLOCKED);
+  CHECK(sim_rtc_idle ());
+
+  // the faults must have reached the callers
+  CHECK(all.busy > 0);
+  CHECK(all.error > 0);
+  CHECK(all.timeout > 0);
+  CHECK(all.invalid_param == 0);
+
+  digest = hash (digest, workers, sizeof(workers));
+  digest = hash (digest, injected, sizeof(injected));
+  t = (time_t) (sim_rtc_time_us () / 1000000);
+  digest = hash (digest, &t, sizeof(t));
+  return digest;
+}
+
+int
+main (int argc, char* argv[])
+{
+  uint32_t seed = (argc > 1) ? (uint32_t) strtoul (argv[1], nullptr, 0) : 1;
+  uint64_t first, second;
+
+  if (seed == 0)
+    seed = 1;
+
+  // the driver converts the calendar with the local time functions
+  setenv ("TZ", "UTC", 1);
+  tzset ();
+
+  first = run (seed, true);
+  second = run (seed, false);
+  printf ("repeated run: digest %016llx, %s\n", (unsigned long long) first,
+          first == second ? "same" : "different");
+  CHECK(first == second);
+
+  printf ("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+  return failures ? 1 : 0;
+}
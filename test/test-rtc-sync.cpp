@@ -0,0 +1,319 @@
+/*
+ * test-rtc-sync.cpp
+ *
+ * Copyright (c) 2026 Lix N. Paulian (lix@paulian.net)
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Created on: 19 Oct 2026 (LNP)
+ */
+
+/*
+ * Host test of the time synchronization: the simulated RTC, with a given
+ * oscillator error and initial offset, is disciplined from a simulated
+ * reference, either NTP like samples (with random delays and asymmetry
+ * errors) or PPS time stamps. It runs on Linux (or any POSIX host):
+ *
+ *   g++ -std=c++11 -O2 -Wall -I../src -Ihost test-rtc-sync.cpp \
+ *       -o test-rtc-sync
+ *   ./test-rtc-sync [seed]
+ *
+ * For each scenario it prints the estimated oscillator error, the time to
+ * converge and the residual offset, as seen by the synchronization (i.e.
+ * including the measurement errors) and as it really is. The program exits
+ * with a non-zero status if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+
+#include "rtc-clock.h"
+#include "rtc-sim.h"
+#include "host-test.h"
+#include "rtc-sync.h"
+
+typedef struct
+{
+  const char* name;
+  double drift;                 // oscillator error, ppm
+  int64_t initial_offset;       // reference - local, us
+  uint32_t interval;            // between samples, s
+  bool pps;                     // PPS or NTP like samples
+  uint32_t duration;            // s
+  uint32_t limit;               // synchronized below this offset, us
+} scenario_t;
+
+static const scenario_t scenarios[] =
+  {
+    { "NTP, 64 s", 37.5, -3200000, 64, false, 8 * 3600, 5000 },
+    { "NTP, 256 s", 8.2, 250000, 256, false, 12 * 3600, 5000 },
+    { "PPS, 32 s", -120.0, 400000, 32, true, 4 * 3600, 2000 },
+    { "PPS, 32 s, fast", 211.7, -12345, 32, true, 4 * 3600, 2000 }, };
+
+// the reference starts at 2017-07-14 02:40:00 UTC
+static constexpr time_t T0 = 1500000000;
+
+// minimum network delay of the NTP like samples, us
+static constexpr uint32_t MIN_DELAY = 5000;
+
+/**
+ * @brief  Return reference time - local time, at the RTC resolution.
+ */
+static int64_t
+true_offset (rtc_sim& sim, int64_t ref)
+{
+  time_t sec;
+  uint32_t usec;
+
+  sim.get_time (&sec, &usec);
+  return ref - ((int64_t) sec * 1000000 + usec);
+}
+
+/**
+ * @brief  Draw the delay and the error of an NTP like sample.
+ * @param  state: generator state.
+ * @param  delay: returns the round trip delay, us.
+ * @return The asymmetry error, us.
+ */
+static int64_t
+ntp_error (uint32_t& state, uint32_t* delay)
+{
+  uint32_t d;
+
+  // queueing delay, mostly short, up to 45 ms; the asymmetry error
+  // is at most the extra delay / 2
+  d = next_random (state) % 45000;
+  d = MIN_DELAY + d * (next_random (state) % 1000) / 1000;
+  *delay = d;
+  return ((int64_t) (next_random (state) % 1001) - 500) * (d - MIN_DELAY)
+      / 1000;
+}
+
+static void
+run (const scenario_t* sc, uint32_t seed)
+{
+  rtc_sim sim;
+  rtc_sync<rtc_sim> sync (sim, sc->limit);
+  uint32_t state = seed;
+  double sum_squares = 0;
+  uint32_t sum_count = 0, rms;
+  int64_t ref = (int64_t) T0 * 1000000;
+  int64_t local = ref - sc->initial_offset;
+  int64_t offset, error;
+  uint32_t delay;
+  time_t sec;
+
+  sim.set_drift (sc->drift);
+  sec = (time_t) (local / 1000000);
+  sim.set_time (&sec);
+  sim.shift_time ((int32_t) (local % 1000000));
+
+  for (uint32_t t = 1; t <= sc->duration; t++)
+    {
+      sim.advance (1000000);
+      ref += 1000000;
+
+      // true residual offset, over the second half of the run
+      if (t > sc->duration / 2)
+        {
+          offset = true_offset (sim, ref);
+          sum_squares += (double) offset * offset;
+          sum_count++;
+        }
+
+      if (t % sc->interval)
+        continue;
+
+      if (sc->pps)
+        {
+          CHECK(sync.add_pps ((time_t) (ref / 1000000)) == rtc_sim::ok);
+        }
+      else
+        {
+          error = ntp_error (state, &delay);
+          offset = true_offset (sim, ref) + error;
+          CHECK(sync.add_sample (offset, delay) == rtc_sim::ok);
+        }
+    }
+
+  offset = true_offset (sim, ref);
+  rms = (uint32_t) sqrt (sum_squares / sum_count);
+  printf ("%-16s %8.1f %8.2f %5u %7u s %6u us %6u us %6d us\n", sc->name,
+          sc->drift, sync.frequency (), (unsigned) sync.steps (),
+          (unsigned) sync.convergence_time (), (unsigned) sync.residual (),
+          (unsigned) rms, (int) offset);
+
+  CHECK(sync.converged ());
+  CHECK(sync.convergence_time () < sc->duration / 2);
+  CHECK(sync.residual () < sc->limit);
+  CHECK(rms < 2000);
+  CHECK(offset < 3000 && offset > -3000);
+  CHECK(sync.frequency () - sc->drift < 1.0
+        && sync.frequency () - sc->drift > -1.0);
+  CHECK(sync.steps () == ((sc->initial_offset >= 1000000
+      || sc->initial_offset <= -1000000) ? 1u : 0u));
+}
+
+/**
+ * @brief  Single bogus samples of several seconds, with a long or a short
+ *      delay, must not set the time; a lasting jump of the reference must,
+ *      once.
+ */
+static void
+run_outliers (uint32_t seed)
+{
+  rtc_sim sim;
+  rtc_sync<rtc_sim> sync (sim, 5000);
+  uint32_t state = seed;
+  int64_t ref = (int64_t) T0 * 1000000;
+  int64_t offset, error, worst = 0;
+  uint32_t delay, steps = 0;
+  time_t sec = T0;
+
+  sim.set_drift (20.0);
+  sim.set_time (&sec);
+
+  for (uint32_t t = 1; t <= 6 * 3600; t++)
+    {
+      sim.advance (1000000);
+      ref += 1000000;
+
+      // the reference jumps 5 s ahead
+      if (t == 4 * 3600)
+        {
+          steps = sync.steps ();
+          ref += 5000000;
+        }
+
+      // the bogus samples must not disturb the clock
+      offset = true_offset (sim, ref);
+      if (t > 7000 && t < 4 * 3600 && (offset > worst || -offset > worst))
+        worst = (offset < 0) ? -offset : offset;
+
+      if (t % 64)
+        continue;
+
+      error = ntp_error (state, &delay);
+      CHECK(sync.add_sample (true_offset (sim, ref) + error, delay)
+          == rtc_sim::ok);
+      if (t == 120 * 64)
+        {
+          CHECK(sync.converged ());
+          CHECK(sync.add_sample (true_offset (sim, ref) + 3000000, 900000)
+              == rtc_sim::ok);
+        }
+      else if (t == 160 * 64)
+        {
+          CHECK(sync.add_sample (true_offset (sim, ref) - 3000000, MIN_DELAY)
+              == rtc_sim::ok);
+        }
+    }
+
+  offset = true_offset (sim, ref);
+  printf ("%-16s %8.1f %8.2f %5u %9s %6u us %6d us %6d us\n", "NTP, outliers",
+          20.0, sync.frequency (), (unsigned) sync.steps (), "",
+          (unsigned) sync.residual (), (int) worst, (int) offset);
+
+  CHECK(steps == 0);
+  CHECK(worst < 3000);
+  CHECK(sync.steps () == 1);
+  CHECK(sync.converged ());
+  CHECK(offset < 3000 && offset > -3000);
+}
+
+/**
+ * @brief  The shift of the fraction fails when the time is set: the whole
+ *      seconds are accounted for, the next samples correct the rest.
+ */
+static void
+run_refused (uint32_t seed)
+{
+  rtc_sim sim;
+  rtc_sync<rtc_sim> sync (sim, 5000);
+  uint32_t state = seed;
+  int64_t ref = (int64_t) T0 * 1000000 + 500000;
+  int64_t offset, error;
+  uint32_t delay;
+  time_t sec = T0 - 3;
+  int refused = 0;
+
+  // 3.5 s late, the fraction left after setting the time is about 0.5 s
+  sim.set_drift (-15.0);
+  sim.set_time (&sec);
+  sim.refuse_shifts (1);
+
+  for (uint32_t t = 1; t <= 4 * 3600; t++)
+    {
+      sim.advance (1000000);
+      ref += 1000000;
+
+      if (t % 64)
+        continue;
+
+      error = ntp_error (state, &delay);
+      if (sync.add_sample (true_offset (sim, ref) + error, delay)
+          == rtc_sim::busy)
+        {
+          // the time was set, only the fraction is left
+          CHECK(sync.steps () == 1);
+          offset = true_offset (sim, ref);
+          CHECK(offset > 0 && offset < 1000000);
+          refused++;
+        }
+    }
+
+  offset = true_offset (sim, ref);
+  printf ("%-16s %8.1f %8.2f %5u %7u s %6u us %9s %6d us\n",
+          "NTP, refused", -15.0, sync.frequency (), (unsigned) sync.steps (),
+          (unsigned) sync.convergence_time (), (unsigned) sync.residual (),
+          "", (int) offset);
+
+  CHECK(refused == 1);
+  CHECK(sync.steps () == 1);
+  CHECK(sync.converged ());
+  CHECK(offset < 3000 && offset > -3000);
+  CHECK(sync.frequency () + 15.0 < 1.0 && sync.frequency () + 15.0 > -1.0);
+}
+
+int
+main (int argc, char* argv[])
+{
+  uint32_t seed = (argc > 1) ? (uint32_t) strtoul (argv[1], nullptr, 0) : 1;
+
+  if (seed == 0)
+    seed = 1;
+
+  printf ("seed %u\n", (unsigned) seed);
+  printf ("%-16s %8s %8s %5s %9s %9s %9s %9s\n", "scenario", "drift",
+          "estim.", "steps", "converg.", "residual", "true rms", "offset");
+
+  for (unsigned i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+    run (&scenarios[i], seed + i);
+  run_outliers (seed);
+  run_refused (seed);
+
+  printf ("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+  return failures ? 1 : 0;
+}